@@ -38,6 +38,8 @@ namespace Config
 
   int   nlayers_per_seed = 3; // can be overriden from Geom plugin; a very confusing variable :)
   int   numSeedsPerTask = 32;
+  bool  finderFillLanes = false;
+  bool  finderLaneStats = false;
   
   // number of hits per task for finding seeds
   int   numHitsPerTask = 32;
@@ -69,6 +71,8 @@ namespace Config
   bool  dumpForPlots = false;
   bool  silent       = false;
 
+  bool  useIterativeHelixAtR = false;
+
   bool  cf_seeding = false;
   bool  cf_fitting = false;
 
@@ -37,6 +37,7 @@ struct PropagationFlags
       bool apply_material     : 1;
       // Could add: bool use_trig_approx  -- now Config::useTrigApprox = true
       // Could add: int  n_iter : 8       -- now Config::Niter = 5
+      // New flags also need to be added to PropagationFlagsT and dispatchPropagationFlags().
     };
 
     unsigned int _raw_;
@@ -49,8 +50,41 @@ struct PropagationFlags
     use_param_b_field       ( pfe & PF_use_param_b_field),
     apply_material          ( pfe & PF_apply_material)
   {}
+
+  int get_pfe() const
+  {
+    return (use_param_b_field ? PF_use_param_b_field : 0) |
+           (apply_material    ? PF_apply_material    : 0);
+  }
+};
+
+// Compile-time counterpart of PropagationFlags. Kernels templated on it drop the
+// branches for options that are off.
+template<int PFE>
+struct PropagationFlagsT
+{
+  static constexpr int  pfe               = PFE;
+  static constexpr bool use_param_b_field = PFE & PF_use_param_b_field;
+  static constexpr bool apply_material    = PFE & PF_apply_material;
 };
 
+// Calls f(PropagationFlagsT<pfe>()) for the flag set given at run-time.
+template<typename F>
+void dispatchPropagationFlags(const PropagationFlags pf, F &&f)
+{
+  switch (pf.get_pfe())
+  {
+    case PF_none:
+      f(PropagationFlagsT<PF_none>()); break;
+    case PF_use_param_b_field:
+      f(PropagationFlagsT<PF_use_param_b_field>()); break;
+    case PF_apply_material:
+      f(PropagationFlagsT<PF_apply_material>()); break;
+    case PF_use_param_b_field | PF_apply_material:
+      f(PropagationFlagsT<PF_use_param_b_field | PF_apply_material>()); break;
+  }
+}
+
 //------------------------------------------------------------------------------
 
 // Enum for input seed options
@@ -162,7 +196,7 @@ namespace Config
   extern float RlgridME[Config::nBinsZME][Config::nBinsRME];
   extern float XigridME[Config::nBinsZME][Config::nBinsRME];
 
-  // This will become layer dependent (in bits). To be consistent with min_dphi.
+  // Default number of phi bins, LayerInfo::m_phi_bits sets it per layer.
   static constexpr int m_nphi = 128;
 
   // config on Event
@@ -228,6 +262,9 @@ namespace Config
   constexpr int Niter    =  5;
   constexpr int NiterSim = 10; // Can make more steps due to near volume misses.
   constexpr bool useTrigApprox = true;
+  constexpr float helixAtRTolerance = 0.0001f; // 1 mum, convergence of helixAtRFromIntersection()
+  // Use the fixed-count helixAtRFromIterativeCCS() as reference instead of helixAtRFromIntersection().
+  extern bool useIterativeHelixAtR;
 
   // PropagationFlags as used during finding and fitting. Defined for each Geom in its plugin.
   extern bool             finding_requires_propagation_to_hit_pos;
@@ -373,6 +410,10 @@ namespace Config
   extern int    finderReportBestOutOfN;
 
   extern int    numSeedsPerTask;
+  // Do not split seed ranges of finding tasks below what can fill NN lanes.
+  extern bool   finderFillLanes;
+  // Collect per-layer lane utilization of Std and CE finding.
+  extern bool   finderLaneStats;
 
   // number of layer1 hits for finding seeds per task
   extern int    numHitsPerTask;
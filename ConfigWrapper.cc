@@ -32,6 +32,7 @@ namespace mkfit {
       TrackerInfo::ExecTrackerInfoCreatorPlugin(Config::geomPlugin, Config::TrkInfo);
 
       fillZRgridME();
+      Config::TrkInfo.fill_material_tables();
     }
 
     void setNTotalLayers(int nTotalLayers) {
@@ -16,6 +16,12 @@
 #endif
 
 #include <memory>
+#include <cstring>
+#include <cstdint>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace
 {
@@ -70,12 +76,19 @@ Event::Event(const Geometry& g, Validation& v, int evtID, int threads) :
 }
 
 void Event::Reset(int evtID)
+{
+  ResetData(evtID);
+  ResetValidation();
+}
+
+void Event::ResetData(int evtID)
 {
   evtID_ = evtID;
   mcHitIDCounter_ = 0;
   reset_nan_n_silly_counters();
 
   for (auto&& l : layerHits_) { l.clear(); }
+  hitsMapped_ = false;
 
   simHitsInfo_.clear();
   simTrackStates_.clear();
@@ -89,7 +102,10 @@ void Event::Reset(int evtID)
   fitTracksExtra_.clear();
   cmsswTracks_.clear();
   cmsswTracksExtra_.clear();
+}
 
+void Event::ResetValidation()
+{
   validation_.resetValidationMaps(); // need to reset maps for every event.
 }
 
@@ -441,6 +457,14 @@ void Event::write_out(DataFile &data_file)
   fseek(fp, start, SEEK_SET);
   fwrite(&evsize, sizeof(int), 1, fp);
   fseek(fp, 0, SEEK_END);
+
+  DataFileIndexEntry ie;
+  ie.f_offset       = start;
+  ie.f_size         = evsize;
+  ie.f_n_sim_tracks = nt;
+  for (int il = 0; il < nl; ++il) ie.f_n_hits += layerHits_[il].size();
+  ie.f_n_seeds      = data_file.HasSeeds() ? seedTracks_.size() : 0;
+  data_file.f_index.push_back(ie);
   
   //layerHitMap_ is recreated afterwards
 
@@ -470,11 +494,17 @@ void Event::write_out(DataFile &data_file)
 // #define DUMP_REC_TRACKS
 // #define DUMP_REC_TRACK_HITS
 
-void Event::read_in(DataFile &data_file, FILE *in_fp)
+void Event::read_in(DataFile &data_file, FILE *in_fp, int i_ev)
 {
+  if (data_file.IsMapped())
+  {
+    read_in_mapped(data_file, i_ev);
+    return;
+  }
+
   FILE *fp = in_fp ? in_fp : data_file.f_fp;
 
-  data_file.AdvancePosToNextEvent(fp);
+  data_file.AdvancePosToNextEvent(fp, i_ev);
 
   int nt;
   fread(&nt, sizeof(int), 1, fp);
@@ -662,6 +692,68 @@ void Event::read_in(DataFile &data_file, FILE *in_fp)
   if (!Config::silent) printf("Read complete, %d simtracks on file.\n", nt);
 }
 
+void Event::read_in_mapped(DataFile &data_file, int i_ev)
+{
+  // Hits and sim-hit infos are used in place, through fileView_. Sections
+  // that get edited during event processing (cleaning and relabeling of
+  // tracks) are copied.
+
+  data_file.FillEventView(i_ev >= 0 ? i_ev : data_file.NextEventIndex(), fileView_);
+
+  const DataFileEventView &v = fileView_;
+
+  simTracks_.assign(v.m_sim_tracks.begin(), v.m_sim_tracks.end());
+  Config::nTracks = v.m_sim_tracks.size();
+
+  if (data_file.HasSimTrackStates())
+  {
+    simTrackStates_.assign(v.m_sim_track_states.begin(), v.m_sim_track_states.end());
+  }
+
+  hitsMapped_ = true;
+
+  if (data_file.HasSeeds() && Config::seedInput == cmsswSeeds)
+  {
+    seedTracks_.assign(v.m_seed_tracks.begin(), v.m_seed_tracks.end());
+  }
+
+  if (data_file.HasCmsswTracks() && Config::readCmsswTracks)
+  {
+    cmsswTracks_.assign(v.m_cmssw_tracks.begin(), v.m_cmssw_tracks.end());
+  }
+
+  if (Config::kludgeCmsHitErrors || Config::quality_val || Config::sim_val || Config::cmssw_val ||
+      Config::fit_val || Config::cmssw_export || Config::dumpForPlots)
+  {
+    FillMappedHits();
+  }
+
+  if (Config::kludgeCmsHitErrors)
+  {
+    kludge_cms_hit_errors();
+  }
+
+  if (!Config::silent) printf("Read complete, %d simtracks on file (mapped).\n", v.m_sim_tracks.size());
+}
+
+void Event::FillMappedHits()
+{
+  if ( ! hitsMapped_) return;
+
+  const DataFileEventView &v = fileView_;
+
+  const int nl = v.m_layer_hits.size();
+  layerHits_.resize(nl);
+  for (int il = 0; il < nl; ++il)
+  {
+    layerHits_[il].assign(v.m_layer_hits[il].begin(), v.m_layer_hits[il].end());
+  }
+
+  simHitsInfo_.assign(v.m_sim_hits_info.begin(), v.m_sim_hits_info.end());
+
+  hitsMapped_ = false;
+}
+
 void Event::setInputFromCMSSW(std::vector<HitVec> hits, TrackVec seeds)
 {
   layerHits_ = std::move(hits);
@@ -774,10 +866,10 @@ void Event::print_tracks(const TrackVec& tracks, bool print_hits) const
         int idx = t.getHitIdx(ih);
         if (idx >= 0)
         {
-          const Hit &hit = layerHits_[lyr][idx];
+          const Hit &hit = layerHits(lyr)[idx];
           printf("    hit %2d lyr=%2d idx=%3d pos r=%7.3f z=% 8.3f   mc_hit=%3d mc_trk=%3d\n",
-                 ih, lyr, idx, layerHits_[lyr][idx].r(), layerHits_[lyr][idx].z(),
-                 hit.mcHitID(), hit.mcTrackID(simHitsInfo_));
+                 ih, lyr, idx, hit.r(), hit.z(),
+                 hit.mcHitID(), simHitInfo(hit.mcHitID()).mcTrackID());
         }
         else
           printf("    hit %2d lyr=%2d idx=%3d\n", ih, t.getHitLyr(ih), t.getHitIdx(ih));
@@ -1019,7 +1111,7 @@ void Event::relabel_cmsswtracks_from_seeds()
 int DataFile::OpenRead(const std::string& fname, bool set_n_layers)
 {
   constexpr int min_ver = 3;
-  constexpr int max_ver = 3;
+  constexpr int max_ver = 4;
 
   f_fp = fopen(fname.c_str(), "r");
   assert (f_fp != 0 && "Opening of input file failed.");
@@ -1054,8 +1146,17 @@ int DataFile::OpenRead(const std::string& fname, bool set_n_layers)
     exit(1);
   }
 
-  printf("Opened file '%s', format version %d, n_max_trk_hits %d, n_layers %d, n_events %d\n",
-         fname.c_str(), f_header.f_format_version, f_header.f_n_max_trk_hits, f_header.f_n_layers, f_header.f_n_events);
+  fseek(f_fp, 0, SEEK_END);
+  f_data_end = ftell(f_fp);
+  if (f_header.f_format_version >= 4)
+  {
+    ReadEventIndex();
+  }
+  fseek(f_fp, f_pos, SEEK_SET);
+
+  printf("Opened file '%s', format version %d, n_max_trk_hits %d, n_layers %d, n_events %d%s\n",
+         fname.c_str(), f_header.f_format_version, f_header.f_n_max_trk_hits, f_header.f_n_layers, f_header.f_n_events,
+         HasEventIndex() ? ", with event index" : "");
   if (f_header.f_extra_sections)
   {
     printf("  Extra sections:");
@@ -1087,24 +1188,35 @@ void DataFile::OpenWrite(const std::string& fname, int nev, int extra_sections)
   f_header.f_extra_sections = extra_sections;
 
   fwrite(&f_header, sizeof(DataFileHeader), 1, f_fp);
+
+  f_writing = true;
+  f_index.clear();
+  f_index.reserve(std::max(nev, 0));
 }
 
-int DataFile::AdvancePosToNextEvent(FILE *fp)
+int DataFile::AdvancePosToNextEvent(FILE *fp, int i_ev)
 {
   int evsize;
 
+  if (i_ev >= 0 || HasReadOrder())
+  {
+    // Explicit event or order, each reader positions its own file handle.
+    const DataFileIndexEntry &e = f_index[i_ev >= 0 ? i_ev : NextEventIndex()];
+    fseek(fp, e.f_offset + sizeof(int), SEEK_SET);
+    return e.f_size;
+  }
+
   std::lock_guard<std::mutex> readlock(f_next_ev_mutex);
 
+  if (Config::loopOverFile && f_pos >= f_data_end)
+  {
+    // File ended, rewind back to beginning. For version >= 4 the event
+    // records are followed by the index so EOF can not be used here.
+    f_pos = sizeof(DataFileHeader);
+  }
+
   fseek(fp, f_pos, SEEK_SET);
   fread(&evsize, sizeof(int), 1, fp);
-  if(Config::loopOverFile) {
-    // File ended, rewind back to beginning
-    if(feof(fp) != 0) {
-      f_pos = sizeof(DataFileHeader);
-      fseek(fp, f_pos, SEEK_SET);
-      fread(&evsize, sizeof(int), 1, fp);
-    }
-  }
 
   f_pos += evsize;
 
@@ -1113,6 +1225,21 @@ int DataFile::AdvancePosToNextEvent(FILE *fp)
 
 void DataFile::SkipNEvents(int n_to_skip)
 {
+  if (IsMapped())
+  {
+    f_next_ev += n_to_skip;
+    return;
+  }
+
+  if (HasEventIndex())
+  {
+    // Find current event in the index and jump directly.
+    auto it = std::lower_bound(f_index.begin(), f_index.end(), f_pos,
+                               [](const DataFileIndexEntry &e, long pos) { return e.f_offset < pos; });
+    SeekToEvent(std::distance(f_index.begin(), it) + n_to_skip);
+    return;
+  }
+
   int evsize;
 
   std::lock_guard<std::mutex> readlock(f_next_ev_mutex);
@@ -1125,11 +1252,300 @@ void DataFile::SkipNEvents(int n_to_skip)
   }
 }
 
+void DataFile::SeekToEvent(int i_ev)
+{
+  // Position reading so that the next event read is i_ev (0-based).
+  // Requires event index.
+
+  assert(i_ev >= 0 && i_ev < (int) f_index.size() && "Event index out of range.");
+
+  if (IsMapped())
+  {
+    f_next_ev = i_ev;
+    return;
+  }
+
+  std::lock_guard<std::mutex> readlock(f_next_ev_mutex);
+
+  f_pos = f_index[i_ev].f_offset;
+}
+
+bool DataFile::ReadEventIndex()
+{
+  DataFileIndexTrailer tr;
+
+  if (f_data_end < (long) (sizeof(DataFileHeader) + sizeof(DataFileIndexTrailer)))
+  {
+    return false;
+  }
+
+  fseek(f_fp, f_data_end - sizeof(DataFileIndexTrailer), SEEK_SET);
+  fread(&tr, sizeof(DataFileIndexTrailer), 1, f_fp);
+
+  if (tr.f_magic != DataFileIndexTrailer().f_magic || tr.f_n_events < 0 ||
+      tr.f_index_pos + tr.f_n_events * (long) sizeof(DataFileIndexEntry) + (long) sizeof(DataFileIndexTrailer) != f_data_end)
+  {
+    fprintf(stderr, "DataFile::ReadEventIndex event index missing or corrupt, reading sequentially.\n");
+    return false;
+  }
+
+  f_index.resize(tr.f_n_events);
+  fseek(f_fp, tr.f_index_pos, SEEK_SET);
+  fread(f_index.data(), sizeof(DataFileIndexEntry), tr.f_n_events, f_fp);
+
+  f_data_end = tr.f_index_pos;
+
+  return true;
+}
+
+void DataFile::WriteEventIndex()
+{
+  fseek(f_fp, 0, SEEK_END);
+
+  DataFileIndexTrailer tr;
+  tr.f_index_pos = ftell(f_fp);
+  tr.f_n_events  = f_index.size();
+
+  fwrite(f_index.data(), sizeof(DataFileIndexEntry), f_index.size(), f_fp);
+  fwrite(&tr, sizeof(DataFileIndexTrailer), 1, f_fp);
+}
+
+//------------------------------------------------------------------------------
+// DataFile -- memory-mapped reading
+//------------------------------------------------------------------------------
+
+namespace
+{
+  // Sections are stored as int count followed by packed objects. Only the
+  // int alignment of a section is guaranteed, copy it out when T needs more.
+  template <typename T>
+  void take_span(const char *&p, DataSpan<T> &s)
+  {
+    memcpy(&s.m_size, p, sizeof(int));
+    p += sizeof(int);
+    if (reinterpret_cast<uintptr_t>(p) % alignof(T) == 0)
+    {
+      s.m_beg = reinterpret_cast<const T*>(p);
+    }
+    else
+    {
+      s.m_copy.resize(s.m_size);
+      memcpy((void*) s.m_copy.data(), p, s.m_size * sizeof(T));
+      s.m_beg = s.m_copy.data();
+    }
+    p += s.m_size * sizeof(T);
+  }
+
+  // Returns the element count of the section at p and moves p past it.
+  template <typename T>
+  int skip_section(const char *&p)
+  {
+    int n;
+    memcpy(&n, p, sizeof(int));
+    p += sizeof(int) + n * sizeof(T);
+    return n;
+  }
+}
+
+bool DataFile::MapFile()
+{
+  // Tracks are handed out as spans of Track, this requires the same layout as on file.
+  if (f_header.f_sizeof_track != (int) sizeof(Track))
+  {
+    fprintf(stderr, "DataFile::MapFile sizeof(Track) on file (%d) differs from current (%d), using stdio reading.\n",
+            f_header.f_sizeof_track, (int) sizeof(Track));
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fileno(f_fp), &st) != 0)
+  {
+    perror("DataFile::MapFile fstat failed");
+    return false;
+  }
+
+  void *m = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fileno(f_fp), 0);
+  if (m == MAP_FAILED)
+  {
+    perror("DataFile::MapFile mmap failed");
+    return false;
+  }
+  madvise(m, st.st_size, MADV_WILLNEED);
+
+  f_map      = (const char*) m;
+  f_map_size = st.st_size;
+
+  if ( ! HasEventIndex())
+  {
+    BuildEventIndex();
+  }
+
+  // Keep the position of a preceding SkipNEvents() / SeekToEvent().
+  auto it = std::lower_bound(f_index.begin(), f_index.end(), f_pos,
+                             [](const DataFileIndexEntry &e, long pos) { return e.f_offset < pos; });
+  f_next_ev = std::distance(f_index.begin(), it);
+
+  return true;
+}
+
+void DataFile::UnmapFile()
+{
+  if (f_map)
+  {
+    munmap((void*) f_map, f_map_size);
+    f_map      = 0;
+    f_map_size = 0;
+  }
+}
+
+void DataFile::BuildEventIndex()
+{
+  // Walk the length-prefixed event records once (for files without an index
+  // table). Event size includes its own size field.
+
+  f_index.clear();
+  f_index.reserve(f_header.f_n_events);
+
+  long pos = sizeof(DataFileHeader);
+  for (int i = 0; i < f_header.f_n_events; ++i)
+  {
+    if (pos + (long) sizeof(int) > f_data_end) break;
+
+    int evsize;
+    memcpy(&evsize, f_map + pos, sizeof(int));
+    if (evsize < (int) sizeof(int) || pos + evsize > f_data_end) break;
+
+    DataFileIndexEntry ie;
+    ie.f_offset = pos;
+    ie.f_size   = evsize;
+
+    // Same section order as in Event::write_out(), only counts are read.
+    const char *p = f_map + pos + sizeof(int);
+
+    ie.f_n_sim_tracks = skip_section<Track>(p);
+    if (HasSimTrackStates()) skip_section<TrackState>(p);
+    int nl;
+    memcpy(&nl, p, sizeof(int)); p += sizeof(int);
+    for (int il = 0; il < nl; ++il)
+    {
+      ie.f_n_hits += skip_section<Hit>(p);
+    }
+    skip_section<MCHitInfo>(p);
+    if (HasSeeds()) ie.f_n_seeds = skip_section<Track>(p);
+
+    f_index.push_back(ie);
+
+    pos += evsize;
+  }
+
+  if ((int) f_index.size() != f_header.f_n_events)
+  {
+    fprintf(stderr, "DataFile::BuildEventIndex found %d events, header says %d.\n",
+            (int) f_index.size(), f_header.f_n_events);
+  }
+}
+
+int DataFile::NextEventIndex()
+{
+  int i_ev = f_next_ev++;
+
+  if (HasReadOrder())
+  {
+    assert(i_ev < (int) f_read_order.size() && "Reading past the end of read order.");
+    return SeqEventIndex(f_read_order[i_ev]);
+  }
+
+  const int n_ev = f_index.size();
+  assert(n_ev > 0 && "Reading from a file without events.");
+  if (Config::loopOverFile && n_ev > 0) i_ev %= n_ev;
+
+  assert(i_ev < n_ev && "Reading past the last event in file.");
+
+  return i_ev;
+}
+
+int DataFile::SeqEventIndex(int seq) const
+{
+  return Config::loopOverFile ? (f_read_first + seq) % (int) f_index.size() : f_read_first + seq;
+}
+
+void DataFile::OrderEventsLargestFirst(int n_events)
+{
+  // Read the next n_events events, as they would come with sequential
+  // reading, in order of decreasing number of hits. Heavy events then start
+  // first and the end of a multi-threaded run is not held up by them.
+  // Requires event index.
+
+  assert(HasEventIndex() && "Event ordering requires event index.");
+
+  if (IsMapped())
+  {
+    f_read_first = f_next_ev;
+  }
+  else
+  {
+    auto it = std::lower_bound(f_index.begin(), f_index.end(), f_pos,
+                               [](const DataFileIndexEntry &e, long pos) { return e.f_offset < pos; });
+    f_read_first = std::distance(f_index.begin(), it);
+  }
+
+  f_read_order.resize(n_events);
+  for (int i = 0; i < n_events; ++i)
+  {
+    f_read_order[i] = i;
+  }
+
+  std::stable_sort(f_read_order.begin(), f_read_order.end(),
+                   [&](int a, int b) { return f_index[SeqEventIndex(a)].f_n_hits > f_index[SeqEventIndex(b)].f_n_hits; });
+
+  f_next_ev = 0;
+}
+
+void DataFile::FillEventView(int i_ev, DataFileEventView &v) const
+{
+  // Same section order as in Event::write_out().
+
+  const char *p = f_map + f_index[i_ev].f_offset + sizeof(int); // skip event size
+
+  take_span(p, v.m_sim_tracks);
+
+  if (HasSimTrackStates()) take_span(p, v.m_sim_track_states);
+  else                     v.m_sim_track_states = DataSpan<TrackState>();
+
+  int nl;
+  memcpy(&nl, p, sizeof(int)); p += sizeof(int);
+  v.m_layer_hits.resize(nl);
+  for (int il = 0; il < nl; ++il)
+  {
+    take_span(p, v.m_layer_hits[il]);
+  }
+
+  take_span(p, v.m_sim_hits_info);
+
+  if (HasSeeds()) take_span(p, v.m_seed_tracks);
+  else            v.m_seed_tracks = DataSpan<Track>();
+
+  if (HasCmsswTracks()) take_span(p, v.m_cmssw_tracks);
+  else                  v.m_cmssw_tracks = DataSpan<Track>();
+}
+
 void DataFile::Close()
 {
+  if (f_writing)
+  {
+    WriteEventIndex();
+  }
+  UnmapFile();
   fclose(f_fp);
   f_fp = 0;
+  f_pos = sizeof(DataFileHeader);
   f_header = DataFileHeader();
+  f_index.clear();
+  f_read_order.clear();
+  f_read_first = 0;
+  f_next_ev  = 0;
+  f_data_end = 0;
+  f_writing  = false;
 }
 
 void DataFile::CloseWrite(int n_written){
@@ -7,12 +7,46 @@
 #include "BinInfoUtils.h"
 #include "Config.h"
 
+#include <atomic>
 #include <mutex>
 
 namespace mkfit {
 
 struct DataFile;
 
+//==============================================================================
+// Read-only views into a memory-mapped DataFile
+//==============================================================================
+
+template <typename T>
+struct DataSpan
+{
+  const T *m_beg  = 0;
+  int      m_size = 0;
+
+  // Backing store used when the data on file is not aligned for T.
+  std::vector<T> m_copy;
+
+  const T* begin() const { return m_beg; }
+  const T* end()   const { return m_beg + m_size; }
+  int      size()  const { return m_size; }
+  bool     empty() const { return m_size == 0; }
+
+  const T& operator[](int i) const { return m_beg[i]; }
+};
+
+// Spans pointing straight into the mapping for one event record, filled by
+// DataFile::FillEventView(). Sections not present on file are left empty.
+struct DataFileEventView
+{
+  DataSpan<Track>              m_sim_tracks;
+  DataSpan<TrackState>         m_sim_track_states;
+  std::vector<DataSpan<Hit>>   m_layer_hits;
+  DataSpan<MCHitInfo>          m_sim_hits_info;
+  DataSpan<Track>              m_seed_tracks;
+  DataSpan<Track>              m_cmssw_tracks;
+};
+
 class Event
 {
 public:
@@ -20,6 +54,11 @@ public:
   Event(const Geometry& g, Validation& v, int evtID, int threads = 1);
 
   void Reset(int evtID);
+  // Reset() in two parts: ResetData() clears event contents, ResetValidation()
+  // the maps of the Validation object, which is shared by all events of an
+  // event thread and must only be touched from that thread.
+  void ResetData(int evtID);
+  void ResetValidation();
   void RemapHits(TrackVec & tracks);
   void Simulate();
   void Segment(BinInfoMap & segmentMap);
@@ -35,7 +74,10 @@ public:
   int  nextMCHitID() { return mcHitIDCounter_++; }
 
   void write_out(DataFile &data_file);
-  void read_in  (DataFile &data_file, FILE *in_fp=0);
+  // i_ev selects the event by its index in the DataFile's event index,
+  // by default the next event is read.
+  void read_in  (DataFile &data_file, FILE *in_fp=0, int i_ev=-1);
+  void read_in_mapped(DataFile &data_file, int i_ev=-1);
   void setInputFromCMSSW(std::vector<HitVec> hits, TrackVec seeds);
 
   void kludge_cms_hit_errors();
@@ -51,6 +93,16 @@ public:
 
   void print_tracks(const TrackVec& tracks, bool print_hits) const;
 
+  // Hits and sim-hit infos of the event. After read_in_mapped() they refer to
+  // the mapped event record and layerHits_ / simHitsInfo_ stay empty until
+  // FillMappedHits() copies them; it is called on reading when validation or
+  // the hit-error kludge need the vectors. Otherwise the vectors are used.
+  int  nHitLayers()      const { return hitsMapped_ ? fileView_.m_layer_hits.size()     : layerHits_.size(); }
+  int  nLayerHits(int l) const { return hitsMapped_ ? fileView_.m_layer_hits[l].size()  : layerHits_[l].size(); }
+  const Hit* layerHits(int l) const { return hitsMapped_ ? fileView_.m_layer_hits[l].begin() : layerHits_[l].data(); }
+  const MCHitInfo& simHitInfo(int i) const { return hitsMapped_ ? fileView_.m_sim_hits_info[i] : simHitsInfo_[i]; }
+  void FillMappedHits();
+
   const Geometry& geom_;
   Validation& validation_;
 
@@ -82,16 +134,30 @@ public:
   int seedMaxLastLayer_[5];
 
   TSVec simTrackStates_;
+
+  // Current event record when reading from a memory-mapped DataFile.
+  DataFileEventView fileView_;
+
+private:
+  bool hitsMapped_ = false; // hits are only in fileView_, see layerHits()
+
+public:
+
   static std::mutex printmutex;
 };
 
 typedef std::vector<Event> EventVec;
 
 
+// Format versions:
+//   3 - header followed by length-prefixed event records;
+//   4 - as 3, plus an event index table and DataFileIndexTrailer at the end
+//       of file, written on Close() of a file opened for writing.
+
 struct DataFileHeader
 {
   int f_magic          = 0xBEEF;
-  int f_format_version = 3;
+  int f_format_version = 4;
   int f_sizeof_track   = sizeof(Track);
   int f_n_max_trk_hits = Config::nMaxTrkHits;
   int f_n_layers       = -1;
@@ -105,6 +171,22 @@ struct DataFileHeader
   }
 };
 
+struct DataFileIndexEntry
+{
+  long long f_offset       = 0; // position of event record (its size field)
+  int       f_size         = 0; // size of event record in bytes
+  int       f_n_hits       = 0; // total number of hits in all layers
+  int       f_n_seeds      = 0; // number of seeds, 0 if not on file
+  int       f_n_sim_tracks = 0;
+};
+
+struct DataFileIndexTrailer
+{
+  long long f_index_pos = 0;
+  int       f_n_events  = 0;
+  int       f_magic     = 0xFEED;
+};
+
 struct DataFile
 {
   enum ExtraSection
@@ -121,6 +203,27 @@ struct DataFile
 
   std::mutex     f_next_ev_mutex;
 
+  // Event index -- read from file (version >= 4), built by BuildEventIndex()
+  // or accumulated by Event::write_out(). f_data_end is the end of the
+  // event records, i.e. the start of the index table if there is one.
+  std::vector<DataFileIndexEntry> f_index;
+  long                            f_data_end = 0;
+  bool                            f_writing  = false;
+
+  // Memory-mapped reading, enabled with MapFile() after OpenRead().
+  // Events are located through f_index and handed out via an atomic
+  // counter, so no locking or file positioning is needed.
+  const char        *f_map      = 0;
+  long               f_map_size = 0;
+  std::atomic<int>   f_next_ev {0};
+
+  // Optional order in which events are read, as sequence numbers the events
+  // would have with sequential reading starting at f_index[f_read_first].
+  // When set, f_next_ev counts position in this vector, for mapped and stdio
+  // reads.
+  std::vector<int>   f_read_order;
+  int                f_read_first = 0;
+
   // ----------------------------------------------------------------
 
   bool HasSimTrackStates() const { return f_header.f_extra_sections & ES_SimTrackStates; }
@@ -130,10 +233,27 @@ struct DataFile
   int  OpenRead (const std::string& fname, bool set_n_layers = false);
   void OpenWrite(const std::string& fname, int nev, int extra_sections=0);
 
-  int  AdvancePosToNextEvent(FILE *fp);
+  int  AdvancePosToNextEvent(FILE *fp, int i_ev=-1);
 
   void SkipNEvents(int n_to_skip);
 
+  bool HasEventIndex() const { return ! f_index.empty(); }
+  bool ReadEventIndex();
+  void WriteEventIndex();
+  void SeekToEvent(int i_ev);
+
+  bool IsMapped() const { return f_map != 0; }
+  bool MapFile();
+  void UnmapFile();
+  void BuildEventIndex();
+  int  NextEventIndex();
+  void OrderEventsLargestFirst(int n_events);
+  bool HasReadOrder() const { return ! f_read_order.empty(); }
+  // Sequence number of the i-th event in read order and its index in f_index.
+  int  ReadOrderSeq(int i) const { return f_read_order[i]; }
+  int  SeqEventIndex(int seq) const;
+  void FillEventView(int i_ev, DataFileEventView &v) const;
+
   void Close();
   void CloseWrite(int n_written); //override nevents in the header and close
 };
@@ -8,6 +8,7 @@
 #include "Matrix.h"
 #include <atomic>
 #include <array>
+#include <cstdint>
 
 namespace mkfit {
 
@@ -265,6 +266,15 @@ typedef std::vector<PairIdx> PairIdxVec;
 typedef std::array<int,3>       TripletIdx;
 typedef std::vector<TripletIdx> TripletIdxVec;
 
+// Type of hit indices in the LayerOfHits phi-q bin tables. 16 bits keep the
+// tables small but limit a layer to 65535 hits -- build with HIT_IDX_32 (see
+// Makefile.config) for very high pileup. HitOnTrack::index allows up to 2^23.
+#ifdef HIT_IDX_32
+typedef uint32_t hit_idx_t;
+#else
+typedef uint16_t hit_idx_t;
+#endif
+
 struct HitOnTrack
 {
   int index : 24;
@@ -98,16 +98,19 @@ public:
       }
    }
 
+   // SlurpIn() gathers element i of the matriplex from arr + i*stride, offset
+   // by vi for each of N_proc lanes. stride > 1 is used for SoA inputs.
+
 #if defined(MIC_INTRINSICS)
 
-   void SlurpIn(const T *arr, __m512i& vi, int scale, const int N_proc = N)
+   void SlurpIn(const T *arr, __m512i& vi, int scale, const int N_proc = N, const int stride = 1)
    {
       //_mm512_prefetch_i32gather_ps(vi, arr, 1, _MM_HINT_T0);
 
       const __m512    src = { 0 };
       const __mmask16 k = N_proc == N ? -1 : (1 << N_proc) - 1;
 
-      for (int i = 0; i < kSize; ++i, ++arr)
+      for (int i = 0; i < kSize; ++i, arr += stride)
       {
          //_mm512_prefetch_i32gather_ps(vi, arr+2, 1, _MM_HINT_NTA);
 
@@ -159,7 +162,7 @@ public:
 
 #elif defined(AVX2_INTRINSICS)
 
-   void SlurpIn(const T *arr, __m256i& vi, int scale, const int N_proc = N)
+   void SlurpIn(const T *arr, __m256i& vi, int scale, const int N_proc = N, const int stride = 1)
    {
       // Casts to float* needed to "support" also T=HitOnTrack.
       // Not needed for AVX_512 (?).
@@ -176,7 +179,7 @@ public:
       __m256i k_master = _mm256_cmpgt_epi32(k_sel, k);
 
       k = k_master;
-      for (int i = 0; i < kSize; ++i, ++arr)
+      for (int i = 0; i < kSize; ++i, arr += stride)
       {
          __m256 reg = _mm256_mask_i32gather_ps(src, (float*) arr, vi, (__m256) k, scale);
          // Restore mask (docs say gather clears it but it doesn't seem to).
@@ -187,7 +190,7 @@ public:
 
 #else
 
-   void SlurpIn(const T *arr, int vi[N], const int N_proc = N)
+   void SlurpIn(const T *arr, int vi[N], const int N_proc = N, const int stride = 1)
    {
       // Separate N_proc == N case (gains about 7% in fit test).
       if (N_proc == N)
@@ -198,7 +201,7 @@ public:
             // #pragma ivdep
             for (int j = 0; j < N; ++j)
             {
-               fArray[i*N + j] = * (arr + i + vi[j]);
+               fArray[i*N + j] = * (arr + i*stride + vi[j]);
             }
          }
       }
@@ -208,7 +211,7 @@ public:
          {
             for (int j = 0; j < N_proc; ++j)
             {
-               fArray[i*N + j] = * (arr + i + vi[j]);
+               fArray[i*N + j] = * (arr + i*stride + vi[j]);
             }
          }
       }
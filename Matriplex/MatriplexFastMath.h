@@ -0,0 +1,367 @@
+#ifndef MatriplexFastMath_H
+#define MatriplexFastMath_H
+
+#include "MatriplexCommon.h"
+
+//==============================================================================
+// Fast float math for Matriplex lane loops
+//==============================================================================
+
+// Branch-free polynomial approximations (Cephes style) of the libm functions
+// used in propagation and hit selection. The float versions contain no libm
+// calls, only arithmetic, bit operations and selects, so lane loops calling
+// them vectorize under "#pragma omp simd" without a SIMD math library.
+// With MPLEX_INTRINSICS there are also overloads taking IntrVec_t.
+//
+// Accuracy, measured by Matriplex/test/fast_math_test.cxx against double
+// precision libm:
+//   fast_atan2  any y, x       abs error < 3e-7 rad; -0 and +0 for x are
+//                              not distinguished.
+//   fast_log    x > 0, normal  abs error < 1e-7 for x in [0.5, 2],
+//                              rel error < 1e-7 elsewhere.
+//   fast_exp    any x          rel error < 2.5e-7 for x in [-87.3, 88],
+//                              outside x is clamped: no infs or denormals.
+//   fast_sincos |x| < 8192     abs error < 1.5e-7.
+//   fast_tan    |x| < 50       rel error < 3e-7 away from poles and zeros.
+//   fast_rsqrt  x > 0          float: 1/sqrt(x), IntrVec_t: hardware
+//                              estimate and one Newton step, rel error
+//                              < 5e-7 on AVX2 and < 2e-7 on AVX-512.
+// The IntrVec_t overloads run the same code on FMVec wrappers.
+
+namespace Matriplex
+{
+namespace FastMath
+{
+
+//------------------------------------------------------------------------------
+// Scalar lane operations
+//------------------------------------------------------------------------------
+
+// fm_min, fm_max and fm_select can also be used directly in lane loops that
+// should vectorize, see applyMaterialEffects().
+
+inline int   as_int  (float a) { int   r; std::memcpy(&r, &a, sizeof(r)); return r; }
+inline float as_float(int   a) { float r; std::memcpy(&r, &a, sizeof(r)); return r; }
+
+inline float to_float(int   a) { return (float) a; }
+inline int   to_int  (float a) { return (int)   a; }
+
+inline float fm_abs (float a) { return std::abs(a); }
+inline bool  is_zero(int   a) { return a == 0; }
+
+// Selects go through bit masks: gcc does not if-convert a ternary with
+// computed operands while FP operations may trap, which is the default.
+// The same holds for std::floor. Inputs of fm_floor fit into an int.
+inline float fm_select(bool m, float a, float b)
+{
+   const int k = - (int) m;
+   return as_float((as_int(a) & k) | (as_int(b) & ~k));
+}
+
+inline float fm_min(float a, float b) { return fm_select(a < b, a, b); }
+inline float fm_max(float a, float b) { return fm_select(a > b, a, b); }
+
+inline float fm_floor(float a)
+{
+   const float t = to_float(to_int(a));
+   return fm_select(t > a, t - 1.f, t);
+}
+
+inline int   fm_shl(int a, int n) { return (int) ((unsigned int) a << n); }
+inline int   fm_shr(int a, int n) { return (int) ((unsigned int) a >> n); }
+
+inline float xor_bits(float a, int b) { return as_float(as_int(a) ^ b); }
+
+template<typename F> struct Traits;
+template<> struct Traits<float> { typedef int I; };
+
+//------------------------------------------------------------------------------
+// Vector lane operations, thin wrappers around IntrVec_t
+//------------------------------------------------------------------------------
+
+#if defined(MPLEX_INTRINSICS) && (defined(__AVX512F__) || defined(__AVX2__))
+
+#define MPLEX_FAST_MATH_INTRINSICS
+
+#if defined(__AVX512F__)
+
+struct FMVec  { __m512  v; FMVec (__m512  a) : v(a) {} FMVec (float a) : v(_mm512_set1_ps(a))    {} };
+struct FMVecI { __m512i v; FMVecI(__m512i a) : v(a) {} FMVecI(int   a) : v(_mm512_set1_epi32(a)) {} };
+struct FMMask { __mmask16 v; };
+
+inline FMVec operator+(const FMVec &a, const FMVec &b) { return _mm512_add_ps(a.v, b.v); }
+inline FMVec operator-(const FMVec &a, const FMVec &b) { return _mm512_sub_ps(a.v, b.v); }
+inline FMVec operator*(const FMVec &a, const FMVec &b) { return _mm512_mul_ps(a.v, b.v); }
+inline FMVec operator/(const FMVec &a, const FMVec &b) { return _mm512_div_ps(a.v, b.v); }
+
+inline FMMask operator<(const FMVec &a, const FMVec &b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ) }; }
+inline FMMask operator>(const FMVec &a, const FMVec &b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ) }; }
+
+inline FMVecI operator+(const FMVecI &a, const FMVecI &b) { return _mm512_add_epi32(a.v, b.v); }
+inline FMVecI operator-(const FMVecI &a, const FMVecI &b) { return _mm512_sub_epi32(a.v, b.v); }
+inline FMVecI operator&(const FMVecI &a, const FMVecI &b) { return _mm512_and_si512(a.v, b.v); }
+inline FMVecI operator|(const FMVecI &a, const FMVecI &b) { return _mm512_or_si512 (a.v, b.v); }
+inline FMVecI operator^(const FMVecI &a, const FMVecI &b) { return _mm512_xor_si512(a.v, b.v); }
+inline FMVecI operator~(const FMVecI &a)                  { return _mm512_xor_si512(a.v, _mm512_set1_epi32(-1)); }
+
+inline FMVecI as_int  (const FMVec  &a) { return _mm512_castps_si512(a.v); }
+inline FMVec  as_float(const FMVecI &a) { return _mm512_castsi512_ps(a.v); }
+
+inline FMVec  to_float(const FMVecI &a) { return _mm512_cvtepi32_ps(a.v); }
+inline FMVecI to_int  (const FMVec  &a) { return _mm512_cvttps_epi32(a.v); }
+
+inline FMVec fm_abs  (const FMVec &a)                 { return as_float(as_int(a) & FMVecI(0x7fffffff)); }
+inline FMVec fm_min  (const FMVec &a, const FMVec &b) { return _mm512_min_ps(a.v, b.v); }
+inline FMVec fm_max  (const FMVec &a, const FMVec &b) { return _mm512_max_ps(a.v, b.v); }
+inline FMVec fm_floor(const FMVec &a)                 { return _mm512_roundscale_ps(a.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+
+inline FMVec  fm_select(const FMMask &m, const FMVec &a, const FMVec &b) { return _mm512_mask_blend_ps(m.v, b.v, a.v); }
+inline FMMask is_zero  (const FMVecI &a)                                 { return { _mm512_testn_epi32_mask(a.v, a.v) }; }
+
+inline FMVecI fm_shl(const FMVecI &a, int n) { return _mm512_sll_epi32(a.v, _mm_cvtsi32_si128(n)); }
+inline FMVecI fm_shr(const FMVecI &a, int n) { return _mm512_srl_epi32(a.v, _mm_cvtsi32_si128(n)); }
+
+inline FMVec fm_rsqrt_estimate(const FMVec &a) { return _mm512_rsqrt14_ps(a.v); }
+
+#else // AVX2
+
+struct FMVec  { __m256  v; FMVec (__m256  a) : v(a) {} FMVec (float a) : v(_mm256_set1_ps(a))    {} };
+struct FMVecI { __m256i v; FMVecI(__m256i a) : v(a) {} FMVecI(int   a) : v(_mm256_set1_epi32(a)) {} };
+struct FMMask { __m256 v; };
+
+inline FMVec operator+(const FMVec &a, const FMVec &b) { return _mm256_add_ps(a.v, b.v); }
+inline FMVec operator-(const FMVec &a, const FMVec &b) { return _mm256_sub_ps(a.v, b.v); }
+inline FMVec operator*(const FMVec &a, const FMVec &b) { return _mm256_mul_ps(a.v, b.v); }
+inline FMVec operator/(const FMVec &a, const FMVec &b) { return _mm256_div_ps(a.v, b.v); }
+
+inline FMMask operator<(const FMVec &a, const FMVec &b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+inline FMMask operator>(const FMVec &a, const FMVec &b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+
+inline FMVecI operator+(const FMVecI &a, const FMVecI &b) { return _mm256_add_epi32(a.v, b.v); }
+inline FMVecI operator-(const FMVecI &a, const FMVecI &b) { return _mm256_sub_epi32(a.v, b.v); }
+inline FMVecI operator&(const FMVecI &a, const FMVecI &b) { return _mm256_and_si256(a.v, b.v); }
+inline FMVecI operator|(const FMVecI &a, const FMVecI &b) { return _mm256_or_si256 (a.v, b.v); }
+inline FMVecI operator^(const FMVecI &a, const FMVecI &b) { return _mm256_xor_si256(a.v, b.v); }
+inline FMVecI operator~(const FMVecI &a)                  { return _mm256_xor_si256(a.v, _mm256_set1_epi32(-1)); }
+
+inline FMVecI as_int  (const FMVec  &a) { return _mm256_castps_si256(a.v); }
+inline FMVec  as_float(const FMVecI &a) { return _mm256_castsi256_ps(a.v); }
+
+inline FMVec  to_float(const FMVecI &a) { return _mm256_cvtepi32_ps(a.v); }
+inline FMVecI to_int  (const FMVec  &a) { return _mm256_cvttps_epi32(a.v); }
+
+inline FMVec fm_abs  (const FMVec &a)                 { return as_float(as_int(a) & FMVecI(0x7fffffff)); }
+inline FMVec fm_min  (const FMVec &a, const FMVec &b) { return _mm256_min_ps(a.v, b.v); }
+inline FMVec fm_max  (const FMVec &a, const FMVec &b) { return _mm256_max_ps(a.v, b.v); }
+inline FMVec fm_floor(const FMVec &a)                 { return _mm256_floor_ps(a.v); }
+
+inline FMVec  fm_select(const FMMask &m, const FMVec &a, const FMVec &b) { return _mm256_blendv_ps(b.v, a.v, m.v); }
+inline FMMask is_zero  (const FMVecI &a)                                 { return { _mm256_castsi256_ps(_mm256_cmpeq_epi32(a.v, _mm256_setzero_si256())) }; }
+
+inline FMVecI fm_shl(const FMVecI &a, int n) { return _mm256_sll_epi32(a.v, _mm_cvtsi32_si128(n)); }
+inline FMVecI fm_shr(const FMVecI &a, int n) { return _mm256_srl_epi32(a.v, _mm_cvtsi32_si128(n)); }
+
+inline FMVec fm_rsqrt_estimate(const FMVec &a) { return _mm256_rsqrt_ps(a.v); }
+
+#endif
+
+inline FMVec xor_bits(const FMVec &a, const FMVecI &b) { return as_float(as_int(a) ^ b); }
+
+template<> struct Traits<FMVec> { typedef FMVecI I; };
+
+#endif
+
+//------------------------------------------------------------------------------
+// Implementations, written once for float and FMVec
+//------------------------------------------------------------------------------
+
+template<typename F>
+inline F copysign_t(F mag, F sgn)
+{
+   typedef typename Traits<F>::I I;
+
+   return as_float((as_int(mag) & I(0x7fffffff)) | (as_int(sgn) & I(~0x7fffffff)));
+}
+
+// Cephes atanf on [0, 1], octant folding done with selects.
+template<typename F>
+inline F atan2_t(F y, F x)
+{
+   const F ax = fm_abs(x), ay = fm_abs(y);
+   const F mx = fm_max(ax, ay), mn = fm_min(ax, ay);
+
+   const F a   = mn / fm_select(mx > F(0.f), mx, F(1.f));
+   const auto big = a > F(0.414213562f); // tan(pi/8)
+   const F t   = fm_select(big, (a - F(1.f)) / (a + F(1.f)), a);
+   const F z   = t * t;
+
+   F r = (((F(8.05374449538e-2f) * z - F(1.38776856032e-1f)) * z
+           + F(1.99777106478e-1f)) * z - F(3.33329491539e-1f)) * z * t + t;
+
+   r = fm_select(big,     r + F(0.785398163f), r);
+   r = fm_select(ay > ax, F(1.570796327f) - r, r);
+   r = fm_select(x < F(0.f), F(3.141592654f) - r, r);
+
+   return copysign_t(r, y);
+}
+
+// Cephes logf: x = m * 2^e with m in [sqrt(1/2), sqrt(2)).
+template<typename F>
+inline F log_t(F x)
+{
+   typedef typename Traits<F>::I I;
+
+   const I i = as_int(x);
+   F e = to_float(fm_shr(i, 23) - I(126));
+   F m = as_float((i & I(0x007fffff)) | I(0x3f000000));
+
+   const auto small = m < F(0.707106781f);
+   e = fm_select(small, e - F(1.f), e);
+   m = fm_select(small, m + m, m) - F(1.f);
+
+   const F z = m * m;
+
+   F p = F(7.0376836292e-2f);
+   p = p * m - F(1.1514610310e-1f);
+   p = p * m + F(1.1676998740e-1f);
+   p = p * m - F(1.2420140846e-1f);
+   p = p * m + F(1.4249322787e-1f);
+   p = p * m - F(1.6668057665e-1f);
+   p = p * m + F(2.0000714765e-1f);
+   p = p * m - F(2.4999993993e-1f);
+   p = p * m + F(3.3333331174e-1f);
+
+   F y = p * m * z;
+   y = y - e * F(2.12194440e-4f);
+   y = y - F(0.5f) * z;
+
+   return m + y + e * F(0.693359375f);
+}
+
+// Cephes expf: exp(x) = 2^n * exp(g) with |g| <= ln(2)/2.
+template<typename F>
+inline F exp_t(F x)
+{
+   typedef typename Traits<F>::I I;
+
+   x = fm_min(fm_max(x, F(-87.3f)), F(88.f));
+
+   const F n = fm_floor(x * F(1.44269504089f) + F(0.5f));
+   x = x - n * F(0.693359375f);
+   x = x + n * F(2.12194440e-4f);
+
+   F p = F(1.9875691500e-4f);
+   p = p * x + F(1.3981999507e-3f);
+   p = p * x + F(8.3334519073e-3f);
+   p = p * x + F(4.1665795894e-2f);
+   p = p * x + F(1.6666665459e-1f);
+   p = p * x + F(5.0000001201e-1f);
+
+   const F y = p * x * x + x + F(1.f);
+
+   return y * as_float(fm_shl(to_int(n) + I(127), 23));
+}
+
+// Cephes sinf/cosf: reduction to [-pi/4, pi/4] by the octant j, extended
+// precision pi/4 in three parts.
+template<typename F>
+inline void sincos_t(F x, F &s, F &c)
+{
+   typedef typename Traits<F>::I I;
+
+   const F ax = fm_abs(x);
+   const I sign_x = as_int(x) ^ as_int(ax);
+
+   I j = to_int(ax * F(1.27323954473516f)); // 4/pi
+   j = (j + I(1)) & I(~1);
+   const F y = to_float(j);
+
+   const I sign_s    = sign_x ^ fm_shl(j & I(4), 29);
+   const I sign_c    = fm_shl(~(j - I(2)) & I(4), 29);
+   const auto swap   = is_zero(j & I(2));
+
+   const F r = ((ax - y * F(0.78515625f)) - y * F(2.4187564849853515625e-4f)) - y * F(3.77489497744594108e-8f);
+   const F z = r * r;
+
+   const F pc = ((F(2.443315711809948e-5f) * z - F(1.388731625493765e-3f)) * z
+                 + F(4.166664568298827e-2f)) * z * z - F(0.5f) * z + F(1.f);
+   const F ps = ((F(-1.9515295891e-4f) * z + F(8.3321608736e-3f)) * z
+                 - F(1.6666654611e-1f)) * z * r + r;
+
+   s = xor_bits(fm_select(swap, ps, pc), sign_s);
+   c = xor_bits(fm_select(swap, pc, ps), sign_c);
+}
+
+// Cephes tanf, same reduction as sincos_t.
+template<typename F>
+inline F tan_t(F x)
+{
+   typedef typename Traits<F>::I I;
+
+   const F ax = fm_abs(x);
+   const I sign_x = as_int(x) ^ as_int(ax);
+
+   I j = to_int(ax * F(1.27323954473516f));
+   j = (j + I(1)) & I(~1);
+   const F y = to_float(j);
+
+   const F r = ((ax - y * F(0.78515625f)) - y * F(2.4187564849853515625e-4f)) - y * F(3.77489497744594108e-8f);
+   const F z = r * r;
+
+   F p = F(9.38540185543e-3f);
+   p = p * z + F(3.11992232697e-3f);
+   p = p * z + F(2.44301354525e-2f);
+   p = p * z + F(5.34112807005e-2f);
+   p = p * z + F(1.33387994085e-1f);
+   p = p * z + F(3.33331568548e-1f);
+
+   F t = p * z * r + r;
+   t = fm_select(is_zero(j & I(2)), t, F(-1.f) / t);
+
+   return xor_bits(t, sign_x);
+}
+
+} // end namespace FastMath
+
+//------------------------------------------------------------------------------
+// Public functions
+//------------------------------------------------------------------------------
+
+inline float fast_atan2(float y, float x) { return FastMath::atan2_t(y, x); }
+inline float fast_log  (float x)          { return FastMath::log_t(x); }
+inline float fast_exp  (float x)          { return FastMath::exp_t(x); }
+inline float fast_tan  (float x)          { return FastMath::tan_t(x); }
+inline float fast_rsqrt(float x)          { return 1.f / std::sqrt(x); }
+
+inline void  fast_sincos(float x, float &s, float &c) { FastMath::sincos_t(x, s, c); }
+
+#ifdef MPLEX_FAST_MATH_INTRINSICS
+
+inline IntrVec_t fast_atan2(IntrVec_t y, IntrVec_t x) { return FastMath::atan2_t<FastMath::FMVec>(y, x).v; }
+inline IntrVec_t fast_log  (IntrVec_t x)              { return FastMath::log_t  <FastMath::FMVec>(x).v; }
+inline IntrVec_t fast_exp  (IntrVec_t x)              { return FastMath::exp_t  <FastMath::FMVec>(x).v; }
+inline IntrVec_t fast_tan  (IntrVec_t x)              { return FastMath::tan_t  <FastMath::FMVec>(x).v; }
+
+inline IntrVec_t fast_rsqrt(IntrVec_t x)
+{
+   using FastMath::FMVec;
+
+   const FMVec a(x);
+   const FMVec r = FastMath::fm_rsqrt_estimate(a);
+
+   return (r * (FMVec(1.5f) - FMVec(0.5f) * a * r * r)).v;
+}
+
+inline void fast_sincos(IntrVec_t x, IntrVec_t &s, IntrVec_t &c)
+{
+   FastMath::FMVec vs(0.f), vc(0.f);
+   FastMath::sincos_t<FastMath::FMVec>(x, vs, vc);
+   s = vs.v;
+   c = vc.v;
+}
+
+#endif
+
+} // end namespace Matriplex
+
+#endif
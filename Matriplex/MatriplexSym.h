@@ -117,16 +117,19 @@ public:
       }
    }
 
+   // SlurpIn() gathers element i of the matriplex from arr + i*stride, offset
+   // by vi for each of N_proc lanes. stride > 1 is used for SoA inputs.
+
 #if defined(MIC_INTRINSICS)
 
-   void SlurpIn(const T *arr, __m512i& vi, int scale, const int N_proc = N)
+   void SlurpIn(const T *arr, __m512i& vi, int scale, const int N_proc = N, const int stride = 1)
    {
       //_mm512_prefetch_i32gather_ps(vi, arr, 1, _MM_HINT_T0);
 
       const __m512    src = { 0 };
       const __mmask16 k = N_proc == N ? -1 : (1 << N_proc) - 1;
 
-      for (int i = 0; i < kSize; ++i, ++arr)
+      for (int i = 0; i < kSize; ++i, arr += stride)
       {
          //_mm512_prefetch_i32gather_ps(vi, arr+2, 1, _MM_HINT_NTA);
 
@@ -179,7 +182,7 @@ public:
 
 #elif defined(AVX2_INTRINSICS)
 
-   void SlurpIn(const T *arr, __m256i& vi, int scale, const int N_proc = N)
+   void SlurpIn(const T *arr, __m256i& vi, int scale, const int N_proc = N, const int stride = 1)
    {
       const __m256 src = { 0 };
 
@@ -188,7 +191,7 @@ public:
       __m256i k_master = _mm256_cmpgt_epi32(k_sel, k);
 
       k = k_master;
-      for (int i = 0; i < kSize; ++i, ++arr)
+      for (int i = 0; i < kSize; ++i, arr += stride)
       {
          __m256 reg = _mm256_mask_i32gather_ps(src, arr, vi, (__m256) k, scale);
          // Restore mask (docs say gather clears it but it doesn't seem to).
@@ -199,7 +202,7 @@ public:
 
 #else
 
-   void SlurpIn(const T *arr, int vi[N], const int N_proc = N)
+   void SlurpIn(const T *arr, int vi[N], const int N_proc = N, const int stride = 1)
    {
       // Separate N_proc == N case (gains about 7% in fit test).
       if (N_proc == N)
@@ -208,7 +211,7 @@ public:
          {
             for (int j = 0; j < N; ++j)
             {
-               fArray[i*N + j] = * (arr + i + vi[j]);
+               fArray[i*N + j] = * (arr + i*stride + vi[j]);
             }
          }
       }
@@ -218,7 +221,7 @@ public:
          {
             for (int j = 0; j < N_proc; ++j)
             {
-               fArray[i*N + j] = * (arr + i + vi[j]);
+               fArray[i*N + j] = * (arr + i*stride + vi[j]);
             }
          }
       }
@@ -0,0 +1,191 @@
+#include "MatriplexFastMath.h"
+
+#include <cstdio>
+#include <cmath>
+#include <random>
+
+/*
+# Accuracy of MatriplexFastMath.h against double precision libm.
+# Compile scalar only / with AVX2 / with AVX-512 IntrVec_t overloads:
+  g++ -std=c++14 -O3 -fopenmp -mavx -I.. fast_math_test.cxx -o fast_math_test
+  g++ -std=c++14 -O3 -fopenmp -mavx2 -mfma -DMPLEX_USE_INTRINSICS -I.. fast_math_test.cxx -o fast_math_test-avx2
+  g++ -std=c++14 -O3 -fopenmp -mavx512f -DMPLEX_USE_INTRINSICS -I.. fast_math_test.cxx -o fast_math_test-avx512
+*/
+
+const int N = 1 << 20;
+
+struct ErrStat
+{
+   const char *name;
+   double      limit;
+   bool        relative;
+   double      max_err  = 0;
+   double      at_x     = 0;
+
+   ErrStat(const char *n, double l, bool r) : name(n), limit(l), relative(r) {}
+
+   void add(double x, float f, double ref)
+   {
+      double err = std::abs(f - ref);
+      if (relative && ref != 0) err /= std::abs(ref);
+      if (err > max_err) { max_err = err; at_x = x; }
+   }
+
+   bool report() const
+   {
+      bool ok = max_err <= limit;
+      printf("%-22s %s err max = %10.3g at x = %12.6g  (limit %.2g)  %s\n",
+             name, relative ? "rel" : "abs", max_err, at_x, limit, ok ? "OK" : "FAILED");
+      return ok;
+   }
+};
+
+alignas(64) float X[N], Y[N], Z[N], R1[N], R2[N];
+
+int main()
+{
+   using namespace Matriplex;
+
+   std::mt19937 gen(42);
+   bool ok = true;
+
+   auto fill = [&](float lo, float hi)
+   {
+      std::uniform_real_distribution<float> u(lo, hi);
+      for (int i = 0; i < N; ++i) X[i] = u(gen);
+      for (int i = 0; i < N; ++i) Y[i] = u(gen);
+   };
+
+   // atan2
+   {
+      ErrStat es("fast_atan2", 3e-7, false);
+      fill(-100.f, 100.f);
+#pragma omp simd
+      for (int i = 0; i < N; ++i) R1[i] = fast_atan2(Y[i], X[i]);
+      for (int i = 0; i < N; ++i) es.add(X[i], R1[i], std::atan2((double) Y[i], (double) X[i]));
+      es.add(0, fast_atan2(0.f, 0.f), 0);
+      es.add(0, fast_atan2(1.f, 0.f), M_PI_2);
+      es.add(0, fast_atan2(-1.f, -1e-30f), -M_PI_2);
+      ok &= es.report();
+   }
+
+   // log
+   {
+      ErrStat es_a("fast_log [0.5, 2]", 1e-7, false);
+      ErrStat es_r("fast_log", 1e-7, true);
+      fill(0.5f, 2.f);
+#pragma omp simd
+      for (int i = 0; i < N; ++i) R1[i] = fast_log(X[i]);
+      for (int i = 0; i < N; ++i) es_a.add(X[i], R1[i], std::log((double) X[i]));
+      std::uniform_real_distribution<float> u(-37.f, 38.f);
+      for (int i = 0; i < N; ++i) X[i] = std::pow(10.f, u(gen));
+#pragma omp simd
+      for (int i = 0; i < N; ++i) R1[i] = fast_log(X[i]);
+      for (int i = 0; i < N; ++i) if (X[i] < 0.5f || X[i] > 2.f) es_r.add(X[i], R1[i], std::log((double) X[i]));
+      ok &= es_a.report();
+      ok &= es_r.report();
+   }
+
+   // exp
+   {
+      ErrStat es("fast_exp", 2.5e-7, true);
+      fill(-87.f, 88.f);
+#pragma omp simd
+      for (int i = 0; i < N; ++i) R1[i] = fast_exp(X[i]);
+      for (int i = 0; i < N; ++i) es.add(X[i], R1[i], std::exp((double) X[i]));
+      ok &= es.report();
+   }
+
+   // sincos, tan
+   {
+      ErrStat es_s("fast_sincos sin", 1.5e-7, false);
+      ErrStat es_c("fast_sincos cos", 1.5e-7, false);
+      ErrStat es_t("fast_tan", 3e-7, true);
+      fill(-10.f, 10.f);
+      for (int i = 0; i < N / 2; ++i) X[i] = X[i] * 819.2f;
+#pragma omp simd
+      for (int i = 0; i < N; ++i) fast_sincos(X[i], R1[i], R2[i]);
+      for (int i = 0; i < N; ++i)
+      {
+         es_s.add(X[i], R1[i], std::sin((double) X[i]));
+         es_c.add(X[i], R2[i], std::cos((double) X[i]));
+      }
+#pragma omp simd
+      for (int i = 0; i < N; ++i) R1[i] = fast_tan(X[i]);
+      for (int i = 0; i < N; ++i)
+      {
+         // Relative error only away from the poles and zeros.
+         const double xd = X[i];
+         if (std::abs(xd) < 10 && std::abs(std::sin(2 * xd)) > 1e-3) es_t.add(xd, R1[i], std::tan(xd));
+      }
+      ok &= es_s.report();
+      ok &= es_c.report();
+      ok &= es_t.report();
+   }
+
+   // rsqrt
+   {
+      ErrStat es("fast_rsqrt", 1.5e-7, true);
+      fill(1e-6f, 1e6f);
+#pragma omp simd
+      for (int i = 0; i < N; ++i) R1[i] = fast_rsqrt(X[i]);
+      for (int i = 0; i < N; ++i) es.add(X[i], R1[i], 1 / std::sqrt((double) X[i]));
+      ok &= es.report();
+   }
+
+#ifdef MPLEX_FAST_MATH_INTRINSICS
+   // IntrVec_t overloads: same algorithms, must agree with the float versions
+   // up to instruction selection. rsqrt uses the hardware estimate instead.
+   // Inputs of both signs exercise sign folding; log and rsqrt take |x|.
+   {
+      const int W = MPLEX_INTRINSICS_WIDTH_BYTES / sizeof(float);
+
+      ErrStat es_t("IntrVec_t atan2", 3e-7, false);
+      ErrStat es_l("IntrVec_t log",   1e-7,   true);
+      ErrStat es_e("IntrVec_t exp",   2.5e-7, true);
+      ErrStat es_s("IntrVec_t sincos sin", 1.5e-7, false);
+      ErrStat es_c("IntrVec_t sincos cos", 1.5e-7, false);
+      ErrStat es_n("IntrVec_t tan",   3e-7,   true);
+      ErrStat es_r("IntrVec_t rsqrt", 5e-7,   true);
+
+      fill(-50.f, 50.f);
+      for (int i = 0; i < N; ++i) Z[i] = X[i] - Y[i];
+      for (int i = 0; i < N; ++i) Y[i] = std::abs(X[i]) + 0.01f;
+      for (int i = 0; i < N; i += W)
+      {
+         IntrVec_t x = *(IntrVec_t*) &X[i], y = *(IntrVec_t*) &Y[i], z = *(IntrVec_t*) &Z[i], s, c;
+
+         *(IntrVec_t*) &R1[i] = fast_atan2(z, x);
+         for (int j = i; j < i + W; ++j) es_t.add(X[j], R1[j], std::atan2((double) Z[j], (double) X[j]));
+
+         *(IntrVec_t*) &R1[i] = fast_log(y);
+         for (int j = i; j < i + W; ++j) es_l.add(Y[j], R1[j], std::log((double) Y[j]));
+
+         *(IntrVec_t*) &R1[i] = fast_exp(x);
+         for (int j = i; j < i + W; ++j) es_e.add(X[j], R1[j], std::exp((double) X[j]));
+
+         fast_sincos(x, s, c);
+         *(IntrVec_t*) &R1[i] = s;
+         *(IntrVec_t*) &R2[i] = c;
+         for (int j = i; j < i + W; ++j) es_s.add(X[j], R1[j], std::sin((double) X[j]));
+         for (int j = i; j < i + W; ++j) es_c.add(X[j], R2[j], std::cos((double) X[j]));
+
+         *(IntrVec_t*) &R1[i] = fast_tan(x);
+         for (int j = i; j < i + W; ++j)
+            if (std::abs(std::sin(2.0 * X[j])) > 1e-3) es_n.add(X[j], R1[j], std::tan((double) X[j]));
+
+         *(IntrVec_t*) &R1[i] = fast_rsqrt(y);
+         for (int j = i; j < i + W; ++j) es_r.add(Y[j], R1[j], 1 / std::sqrt((double) Y[j]));
+      }
+      ok &= es_t.report();
+      ok &= es_l.report();
+      ok &= es_e.report();
+      ok &= es_s.report();
+      ok &= es_c.report();
+      ok &= es_n.report();
+      ok &= es_r.report();
+   }
+#endif
+
+   return ok ? 0 : 1;
+}
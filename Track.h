@@ -423,9 +423,9 @@ public:
         // do not enter the efficiency denominator.
         bool not_findable : 1;
 
-        // Set to true when number of holes would exceed an external limit, Config::maxHolesPerCand.
-        // XXXXMT Not used yet, -2 last hit idx is still used! Need to add it to MkFi**r classes.
-        // Problem is that I have to carry bits in/out of the MkFinder, too.
+        // Set to true when number of holes would exceed an external limit, Config::maxHolesPerCand
+        // (the -2 hit is still recorded), or when the candidate left the detector or its state
+        // became invalid. Stopped candidates are kept but no longer propagated in finding.
 	bool stopped : 1;
 
         // Production type (most useful for sim tracks): 0, 1, 2, 3 for unset, signal, in-time PU, oot PU
@@ -457,6 +457,7 @@ public:
   };
 
   Status  getStatus() const  { return  status_; }
+  void    setStatus(Status s) { status_ = s; }
   // Maybe needed for MkFi**r copy in / out
   // Status& refStatus() { return  status_; }
   // Status* ptrStatus() { return &status_; }
@@ -482,9 +483,8 @@ public:
   bool hasNonStoredHits() const { return status_.has_non_stored_hits; }
   void setHasNonStoredHits()    { status_.has_non_stored_hits = true; }
 
-  // To be used later
-  // bool isStopped() const { return status_.stopped; }
-  // void setStopped()      { status_.stopped = true; }
+  bool isStopped() const { return status_.stopped; }
+  void setStopped()      { status_.stopped = true; }
 
 private:
 
@@ -569,24 +569,21 @@ inline int getScoreCalc(const unsigned int seedtype,
   }
   */
   ////// V1 of candidate score (after fix for counts of # missing hits):
-  // For high pT central tracks: 4x valid hit bonus and 0.25x missing hit penalty
-  if(seedtype==1){
-    score_ = (Config::validHitBonus_*4.0f)*nfoundhits - Config::missingHitPenalty_*nmisshits*0.25f - chi2;
-    if(pt<0.9f) score_ -= 0.25f*(Config::validHitBonus_)*nfoundhits;
-    if(nfoundhits>8) score_ += (Config::validHitBonus_*2.0f)*nfoundhits;
-  }
-  // For low pT endcap tracks: 2x valid hit bonus & 0.25x missing hit penalty
-  else if(seedtype==2){
-    score_ = (Config::validHitBonus_*2.0f)*nfoundhits - Config::missingHitPenalty_*nmisshits*0.25f - chi2;
-    if(pt<0.9f) score_ -= 0.25f*(Config::validHitBonus_*0.5f)*nfoundhits;
-    if(nfoundhits>8) score_ += (Config::validHitBonus_*1.0f)*nfoundhits;
-  }
-  // For all other tracks: 4x cmssw bonus and unchanged missing hit penalty
-  else{
-    score_ = (Config::validHitBonus_*4.0f)*nfoundhits - Config::missingHitPenalty_*nmisshits - chi2;
-    if(pt<0.9f) score_ -= 0.2f*(Config::validHitBonus_)*nfoundhits;
-    if(nfoundhits>8) score_ += (Config::validHitBonus_)*nfoundhits;
-  }
+  // Written without branches so it can be used in vectorized loops. Per seed type:
+  // 1 - high pT central tracks: 4x valid hit bonus and 0.25x missing hit penalty
+  // 2 - low pT endcap tracks: 2x valid hit bonus & 0.25x missing hit penalty
+  // other tracks: 4x cmssw bonus and unchanged missing hit penalty
+  const bool st1 = seedtype==1, st2 = seedtype==2;
+  const float valid_bonus  = st2 ? Config::validHitBonus_*2.0f : Config::validHitBonus_*4.0f;
+  const float miss_scale   = (st1 || st2) ? 0.25f : 1.0f;
+  const float low_pt_malus = st1 ? 0.25f*(Config::validHitBonus_) :
+                             st2 ? 0.25f*(Config::validHitBonus_*0.5f) : 0.2f*(Config::validHitBonus_);
+  const float long_bonus   = st1 ? Config::validHitBonus_*2.0f : Config::validHitBonus_;
+
+  score_ = valid_bonus*nfoundhits - Config::missingHitPenalty_*nmisshits*miss_scale - chi2;
+  score_ -= (pt<0.9f ? low_pt_malus : 0.0f)*nfoundhits;
+  score_ += (nfoundhits>8 ? long_bonus : 0.0f)*nfoundhits;
+
   score = (int)(floor(10.f * score_ + 0.5));
   return score;
 }
@@ -605,6 +602,12 @@ inline int getScoreCand(const Track& cand1)
   return getScoreCalc(seedtype,nfoundhits,nmisshits,chi2,pt);
 }
 
+// Chi2 range used in score calculation, see getScoreStruct().
+inline float clampChi2ForRanking(float chi2)
+{
+  return chi2 < 0 ? 0.f : (chi2 > Config::maxChi2ForRanking_ ? Config::maxChi2ForRanking_ : chi2);
+}
+
 inline int getScoreStruct(const IdxChi2List& cand1)
 {
   unsigned int seedtype = cand1.seedtype;
@@ -1,5 +1,7 @@
 #include "TrackerInfo.h"
+#include "MaterialEffects.h"
 
+#include <algorithm>
 #include <cassert>
 
 namespace mkfit {
@@ -61,7 +63,7 @@ void TrackerInfo::create_layers(int n_brl, int n_ec_pos, int n_ec_neg)
 int TrackerInfo::new_layer(LayerInfo::LayerType_e type)
 {
   int l = (int) m_layers.size();
-  m_layers.emplace_back(LayerInfo(l, type));
+  m_layers.emplace_back(l, type);
   return l;
 }
 
@@ -100,6 +102,98 @@ bool TrackerInfo::are_layers_siblings(int l1, int l2) const
     return l2 == i1.m_sibl_barrel;
 }
 
+void TrackerInfo::fill_material_tables()
+{
+  // Tracks further than this outside of a layer do not cross it and get no material.
+  constexpr int n_margin_bins = 10;
+
+  for (auto &li : m_layers)
+  {
+    li.m_mat_rl.clear();
+    li.m_mat_xi.clear();
+
+    if (li.is_barrel())
+    {
+      const int rb = getRbinME(li.m_propagate_to);
+      const int nb = std::min(getZbinME(std::max(std::abs(li.m_zmin), std::abs(li.m_zmax))) + 1 + n_margin_bins,
+                              Config::nBinsZME);
+      if (rb < 0 || rb >= Config::nBinsRME) continue;
+
+      for (int zb = 0; zb < nb; ++zb)
+      {
+        li.m_mat_rl.push_back(getRlVal(zb, rb));
+        li.m_mat_xi.push_back(getXiVal(zb, rb));
+      }
+    }
+    else
+    {
+      const int zb = getZbinME(li.m_propagate_to);
+      const int nb = std::min(getRbinME(li.m_rout) + 1 + n_margin_bins, Config::nBinsRME);
+      if (zb < 0 || zb >= Config::nBinsZME) continue;
+
+      for (int rb = 0; rb < nb; ++rb)
+      {
+        li.m_mat_rl.push_back(getRlVal(zb, rb));
+        li.m_mat_xi.push_back(getXiVal(zb, rb));
+      }
+    }
+  }
+}
+
+bool TrackerInfo::read_phi_bins(const std::string& fname)
+{
+  FILE *fp = fopen(fname.c_str(), "r");
+  if ( ! fp)
+  {
+    fprintf(stderr, "TrackerInfo::read_phi_bins can not open '%s'.\n", fname.c_str());
+    return false;
+  }
+
+  char line[256];
+  int  n_set = 0;
+  bool ok    = true;
+  while (fgets(line, sizeof(line), fp))
+  {
+    if (line[0] == '#' || line[0] == '\n') continue;
+
+    int lid, bits;
+    if (sscanf(line, "%d %d", &lid, &bits) != 2 ||
+        lid < 0 || lid >= (int) m_layers.size() || bits < 1 || bits > 10)
+    {
+      fprintf(stderr, "TrackerInfo::read_phi_bins bad line in '%s': %s", fname.c_str(), line);
+      ok = false;
+      break;
+    }
+    m_layers[lid].m_phi_bits = bits;
+    ++n_set;
+  }
+  fclose(fp);
+
+  if (ok) printf("TrackerInfo::read_phi_bins set phi binning of %d layers from '%s'\n", n_set, fname.c_str());
+
+  return ok;
+}
+
+bool TrackerInfo::write_phi_bins(const std::string& fname) const
+{
+  FILE *fp = fopen(fname.c_str(), "w");
+  if ( ! fp)
+  {
+    fprintf(stderr, "TrackerInfo::write_phi_bins can not open '%s'.\n", fname.c_str());
+    return false;
+  }
+
+  fprintf(fp, "# layer_id phi_bits\n");
+  for (auto &l : m_layers)
+  {
+    fprintf(fp, "%d %d\n", l.m_layer_id, l.m_phi_bits);
+  }
+  fclose(fp);
+
+  return true;
+}
+
+
 
 //==============================================================================
 // Plugin Loader
@@ -118,6 +212,8 @@ void TrackerInfo::ExecTrackerInfoCreatorPlugin(const std::string& base, TrackerI
 {
 #ifdef __MIC__
   std::string soname = base + "-mic.so";
+#elif defined(MKFIT_ISA_VARIANT)
+  std::string soname = base + "-" MKFIT_ISA_VARIANT ".so";
 #else
   std::string soname = base + ".so";
 #endif
@@ -55,6 +55,7 @@ public:
 
   // Selection limits
   float         m_q_bin; // > 0 - bin width, < 0 - number of bins
+  int           m_phi_bits = 7; // number of phi bins is 1 << m_phi_bits, max 10
   float         m_select_min_dphi, m_select_max_dphi;
   float         m_select_min_dq,   m_select_max_dq;
 
@@ -80,6 +81,13 @@ public:
   float         m_phif_lpt_treg = 1.0f;
   float         m_phif_lpt_ec   = 1.0f;
 
+  // Material on the layer surface: a slice of the Config::RlgridME / XigridME (z, r) grid
+  // at m_propagate_to, in |z| for barrel and in r for endcap layers, with the same binning.
+  // Only valid for propagation to m_propagate_to, propagation to hits uses the grid.
+  // Covers the layer extent plus a margin, empty when material is not used.
+  // See fill_material_tables().
+  std::vector<float> m_mat_rl, m_mat_xi;
+
   // Additional stuff needed?
   // * pixel / strip, mono / stereo
   // * resolutions, min/max search windows
@@ -186,6 +194,9 @@ public:
 
   bool are_layers_siblings(int l1, int l2) const;
 
+  // Slice the global material grid along each layer, call after fillZRgridME().
+  void fill_material_tables();
+
   bool is_barrel(float eta) const
   {
     return std::abs(eta) < m_eta_trans_beg;
@@ -276,6 +287,11 @@ public:
     return (nb >= 0) ? m_layers[nb] : s_undefined_layer;
   }
 
+  // Per-layer phi binning table, text lines of "layer_id phi_bits".
+  // Can be loaded by geometry plugins or from mkFit command line.
+  bool read_phi_bins (const std::string& fname);
+  bool write_phi_bins(const std::string& fname) const;
+
   static void ExecTrackerInfoCreatorPlugin(const std::string& base, TrackerInfo &ti, bool verbose=false);
 };
 
@@ -2,6 +2,8 @@
 
 #include "HitStructures.h"
 
+#include <algorithm>
+
 //#define DEBUG
 #include "Debug.h"
 
@@ -14,10 +16,27 @@ inline bool sortCandListByHitsChi2(const mkfit::IdxChi2List& cand1,
   return cand1.nhits > cand2.nhits;
 }
 
-inline bool sortCandListByScore(const mkfit::IdxChi2List& cand1,
-				const mkfit::IdxChi2List& cand2)
+// Selects best k entries of a seed chain by score into top (sorted), returns their number.
+// Insertion into a k-long sorted buffer of packed keys, k is small.
+// Chains follow buffer order so buffer index serves as the tie-breaker.
+int selectTopKByScore(const int *score, const int *next, int first, int k, uint64_t *top)
 {
-  return mkfit::sortByScoreStruct(cand1,cand2);
+  int n = 0;
+  for (int i = first; i >= 0; i = next[i])
+  {
+    const uint64_t key = mkfit::getScoreSortKey(score[i], i);
+
+    if (n == k && key >= top[k - 1]) continue;
+
+    int j = (n < k) ? n++ : k - 1;
+    while (j > 0 && top[j - 1] > key)
+    {
+      top[j] = top[j - 1];
+      --j;
+    }
+    top[j] = key;
+  }
+  return n;
 }
 }
 
@@ -25,6 +44,55 @@ namespace mkfit {
 
 //==============================================================================
 
+void CandCloner::add_cands(const MPlexQI &seed_idx, int seed_offset, const MPlexQI &trk_idx,
+                           const MPlexQI &hit_idx, const MPlexQF &chi2, const MPlexQI &score,
+                           const MPlexQI &accept, int N_proc)
+{
+  if ((int) m_cand_seed.size() < m_n_cands + NN)
+  {
+    const int n = std::max(2 * (int) m_cand_seed.size(), m_n_cands + NN);
+    m_cand_seed   .resize(n);
+    m_cand_pos    .resize(n);
+    m_cand_trk_idx.resize(n);
+    m_cand_hit_idx.resize(n);
+    m_cand_chi2   .resize(n);
+    m_cand_score  .resize(n);
+    m_cand_next   .resize(n);
+  }
+
+  // Compress-store: every lane is written, the position only advances for accepted ones.
+  const int n_beg = m_n_cands;
+  int       n     = n_beg;
+  for (int i = 0; i < N_proc; ++i)
+  {
+    m_cand_seed   [n] = seed_idx[i] - seed_offset;
+    m_cand_pos    [n] = m_prop_pos + i;
+    m_cand_trk_idx[n] = trk_idx[i];
+    m_cand_hit_idx[n] = hit_idx[i];
+    m_cand_chi2   [n] = chi2[i];
+    m_cand_score  [n] = score[i];
+    n += accept[i] ? 1 : 0;
+  }
+
+  // Link new entries to the chains of their seeds.
+  for (int i = n_beg; i < n; ++i)
+  {
+    const int is = m_cand_seed[i];
+
+    m_cand_next[i] = -1;
+    if (m_seed_first[is] < 0) m_seed_first[is]              = i;
+    else                      m_cand_next[m_seed_last[is]]  = i;
+    m_seed_last[is] = i;
+    ++m_seed_count[is];
+
+    m_idx_max = std::max(m_idx_max, is);
+  }
+
+  m_n_cands = n;
+}
+
+//==============================================================================
+
 void CandCloner::ProcessSeedRange(int is_beg, int is_end)
 {
   // Process new hits for a range of seeds.
@@ -38,55 +106,66 @@ void CandCloner::ProcessSeedRange(int is_beg, int is_end)
   //1) sort the candidates
   for (int is = is_beg; is < is_end; ++is)
   {
-    std::vector<IdxChi2List>& hitsForSeed = m_hits_to_add[is];
+    const int seed_first = m_seed_first[is];
 
     CombCandidate      &ccand  = cands[m_start_seed + is];
-    std::vector<Track> &extras = (*mp_extra_cands)[is];
+    std::vector<TrackCand> &extras = (*mp_extra_cands)[is];
+
+    // Extras come in candidate order, except for stopped ones that are put in
+    // front of them in find_tracks_unroll_candidates().
+    if ( ! std::is_sorted(extras.begin(), extras.end(), sortByScoreTrackCand))
+      std::stable_sort(extras.begin(), extras.end(), sortByScoreTrackCand);
+
     auto extra_i = extras.begin();
     auto extra_e = extras.end();
 
-    // Extras sorted now
-    // std::sort(extras.begin(), extras.end(), sortByScoreCand);
-
 #ifdef DEBUG
-    dprint("  seed n " << is << " with input candidates=" << hitsForSeed.size());
-    for (int ih = 0; ih < (int) hitsForSeed.size(); ih++)
+    dprint("  seed n " << is << " with input candidates=" << m_seed_count[is]);
+    for (int ih = seed_first; ih >= 0; ih = m_cand_next[ih])
     {
-      dprint("trkIdx=" << hitsForSeed[ih].trkIdx << " hitIdx=" << hitsForSeed[ih].hitIdx << " chi2=" <<  hitsForSeed[ih].chi2 << std::endl
+      const int ti = m_cand_trk_idx[ih];
+      dprint("trkIdx=" << ti << " hitIdx=" << m_cand_hit_idx[ih] << " chi2=" <<  m_cand_chi2[ih] << std::endl
              << "    "
-             << "original pt=" << ccand[hitsForSeed[ih].trkIdx].pT() << " "
-             << "nTotalHits="  << cdand[hitsForSeed[ih].trkIdx].nTotalHits() << " "
-             << "nFoundHits="  << ccand[hitsForSeed[ih].trkIdx].nFoundHits() << " "
-             << "chi2="        << ccand[hitsForSeed[ih].trkIdx].chi2());
+             << "original pt=" << ccand[ti].pT() << " "
+             << "nTotalHits="  << ccand[ti].nTotalHits() << " "
+             << "nFoundHits="  << ccand[ti].nFoundHits() << " "
+             << "chi2="        << ccand[ti].chi2());
     }
 #endif
 
-    if ( ! hitsForSeed.empty())
+    if (seed_first >= 0)
     {
-      //sort the new hits
-      std::sort(hitsForSeed.begin(), hitsForSeed.end(), sortCandListByScore);
+      // select the best new hits, only packed keys get sorted
+      uint64_t *top_keys = t_top_keys.data();
 
-      int num_hits = std::min((int) hitsForSeed.size(), Config::maxCandsPerSeed);
+      int num_hits = selectTopKByScore(m_cand_score.data(), m_cand_next.data(), seed_first,
+                                       Config::maxCandsPerSeed, top_keys);
 
       // This is from buffer, we know it was cleared after last usage.
-      std::vector<Track> &cv = t_cands_for_next_lay[is - is_beg];
+      std::vector<TrackCand> &cv = t_cands_for_next_lay[is - is_beg];
 
       int n_pushed = 0;
 
       for (int ih = 0; ih < num_hits; ih++)
       {
-        const IdxChi2List &h2a = hitsForSeed[ih];
-
-        Track cc( ccand[h2a.trkIdx] );
-        cc.addHitIdx(h2a.hitIdx, m_layer, 0);
-        cc.setChi2(h2a.chi2);
-        cc.setCandScore(h2a.score);
-        // h2a already carries correct score
+        const int ie      = getScoreSortKeyIdx(top_keys[ih]);
+        const int hit_idx = m_cand_hit_idx[ie];
+        const int score   = m_cand_score[ie];
+
+        // Only the state is copied, the new hit is appended to the seed's node arena.
+        // Parent's propagated state is only needed without a hit, otherwise the
+        // Kalman update reads it directly from the per-batch store.
+        TrackCand cc( ccand[m_cand_trk_idx[ie]] );
+        if (hit_idx < 0) get_propagated(m_cand_pos[ie], cc);
+        cc.addHitIdx(hit_idx, m_layer, 0);
+        cc.setChi2(m_cand_chi2[ie]);
+        cc.setCandScore(score);
+        // buffer already carries correct score
         // cc.setCandScore( getScoreCand( cc );
 
-        if (h2a.hitIdx == -2)
+        if (hit_idx == -2)
         {
-          if (h2a.score > ccand.m_best_short_cand.getCandScore())
+          if (score > ccand.m_best_short_cand.getCandScore())
           {
             ccand.m_best_short_cand = cc;
           }
@@ -96,7 +175,7 @@ void CandCloner::ProcessSeedRange(int is_beg, int is_end)
         // Could also skip storing of cands with last -3 hit.
 
         // Squeeze in extra tracks that are better than current one.
-        while (extra_i != extra_e && sortByScoreCand(*extra_i, cc) && n_pushed < Config::maxCandsPerSeed)
+        while (extra_i != extra_e && sortByScoreTrackCand(*extra_i, cc) && n_pushed < Config::maxCandsPerSeed)
         {
           cv.emplace_back(*extra_i);
           ++n_pushed;
@@ -109,9 +188,10 @@ void CandCloner::ProcessSeedRange(int is_beg, int is_end)
         cv.emplace_back( cc );
         ++n_pushed;
 
-        if (h2a.hitIdx >= 0)
+        if (hit_idx >= 0)
         {
           mp_kalman_update_list->push_back(std::pair<int,int>(m_start_seed + is, n_pushed - 1));
+          m_kalman_update_src.push_back(m_cand_pos[ie]);
         }
       }
 
@@ -127,11 +207,11 @@ void CandCloner::ProcessSeedRange(int is_beg, int is_end)
       ccand.resize(cv.size());
       for (size_t ii = 0; ii < cv.size(); ++ii)
       {
-	memcpy( & ccand[ii], & cv[ii], sizeof(Track));
+	ccand[ii] = cv[ii];
       }
       cv.clear();
     }
-    else // hitsForSeed.empty()
+    else // no new hits for this seed
     {
       if (ccand.m_state == CombCandidate::Finding)
       {
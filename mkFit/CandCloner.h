@@ -2,13 +2,13 @@
 #define CandCloner_h
 
 #include "MkFinder.h"
+#include "HitStructures.h"
+#include "align_alloc.h"
 
 #include <vector>
 
 namespace mkfit {
 
-class EventOfCombCandidates;
-
 //#define CC_TIME_LAYER
 //#define CC_TIME_ETA
 
@@ -24,7 +24,10 @@ private:
   // Temporaries in ProcessSeedRange(), resized/reserved  in constructor.
 
   // Size of this one is s_max_seed_range
-  std::vector<std::vector<Track> > t_cands_for_next_lay;
+  std::vector<std::vector<TrackCand> > t_cands_for_next_lay;
+
+  // Size of this one is Config::maxCandsPerSeed
+  std::vector<uint64_t> t_top_keys;
 
 public:
   CandCloner()
@@ -34,34 +37,45 @@ public:
     {
       t_cands_for_next_lay[iseed].reserve(Config::maxCandsPerSeed);
     }
+    t_top_keys.resize(Config::maxCandsPerSeed);
   }
 
   ~CandCloner()
   {
   }
 
-  void begin_eta_bin(EventOfCombCandidates           *e_o_ccs,
-                     std::vector<std::pair<int,int>> *update_list,
-                     std::vector<std::vector<Track>> *extra_cands,
-                     int start_seed, int n_seeds)
+  // Returns 1 if new-hit buffers had to grow since the previous call.
+  int begin_eta_bin(EventOfCombCandidates           *e_o_ccs,
+                    std::vector<std::pair<int,int>> *update_list,
+                    std::vector<std::vector<TrackCand>> *extra_cands,
+                    int start_seed, int n_seeds)
   {
     mp_event_of_comb_candidates = e_o_ccs;
     mp_kalman_update_list       = update_list;
     mp_extra_cands              = extra_cands;
     m_start_seed = start_seed;
     m_n_seeds    = n_seeds;
-    m_hits_to_add.resize(n_seeds);
 
-    // XXX Should resize vectors in m_hits_to_add to whatever makes sense ???
-    // for (int i = 0; i < n_seeds; ++i)
-    // {
-    //   m_hits_to_add[i].reserve(20 * Config::maxCandsPerSeed);
-    // }
+    // Only grow, the new-hit buffer is reset in end_layer() and keeps capacity.
+    if ((int) m_seed_first.size() < n_seeds)
+    {
+      m_seed_first.resize(n_seeds);
+      m_seed_last .resize(n_seeds);
+      m_seed_count.resize(n_seeds);
+    }
+    reset_seed_chains(n_seeds);
+
+    size_t cap = m_seed_first.capacity() + m_cand_seed.size() +
+                 m_prop_err.capacity() + m_kalman_update_src.capacity();
+    const int grew = cap > m_hits_capacity;
+    m_hits_capacity = cap;
 
 #ifdef CC_TIME_ETA
     printf("CandCloner::begin_eta_bin\n");
     t_eta = dtime();
 #endif
+
+    return grew;
   }
 
   void begin_layer(int lay)
@@ -72,6 +86,7 @@ public:
     m_idx_max_prev = 0;
 
     mp_kalman_update_list->clear();
+    m_kalman_update_src.clear();
 
 #ifdef CC_TIME_LAYER
     t_lay = dtime();
@@ -83,16 +98,41 @@ public:
     // Do nothing, "secondary" state vars updated when work completed/assigned.
   }
 
-  void add_cand(int idx, const IdxChi2List& cand_info)
+  // Keeps propagated state of the finder batch starting at position pos of the
+  // layer's candidate list. It is not copied back into TrackCands, clones and
+  // the Kalman update read it from here. Batches come in order, the store
+  // only grows by appending the batch being stored.
+  void store_propagated(int pos, const MPlexLS &err, const MPlexLV &par)
   {
-    m_hits_to_add[idx].push_back(cand_info);
+    const int b = pos / NN;
+    assert (b <= (int) m_prop_err.size());
+    if (b == (int) m_prop_err.size())
+    {
+      m_prop_err.emplace_back(err);
+      m_prop_par.emplace_back(par);
+    }
+    else
+    {
+      m_prop_err[b] = err;
+      m_prop_par[b] = par;
+    }
+    m_prop_pos = pos;
+  }
 
-    m_idx_max = std::max(m_idx_max, idx);
+  void get_propagated(int pos, TrackCand &tc) const
+  {
+    m_prop_err[pos / NN].CopyOut(pos % NN, tc.errors_nc().Array());
+    m_prop_par[pos / NN].CopyOut(pos % NN, tc.parameters_nc().Array());
   }
 
+  // Appends accepted lanes of a finder batch, seed_idx is offset by seed_offset.
+  void add_cands(const MPlexQI &seed_idx, int seed_offset, const MPlexQI &trk_idx,
+                 const MPlexQI &hit_idx, const MPlexQF &chi2, const MPlexQI &score,
+                 const MPlexQI &accept, int N_proc);
+
   int num_cands(int idx)
   {
-    return m_hits_to_add[idx].size();
+    return m_seed_count[idx];
   }
 
   void end_iteration()
@@ -115,10 +155,7 @@ public:
       DoWork(m_n_seeds);
     }
 
-    for (int i = 0; i < m_n_seeds; ++i)
-    {
-      m_hits_to_add[i].clear();
-    }
+    reset_seed_chains(m_n_seeds);
 
 #ifdef CC_TIME_LAYER
     t_lay = dtime() - t_lay;
@@ -165,14 +202,45 @@ public:
 
   // ----------------------------------------------------------------
 
+  void reset_seed_chains(int n_seeds)
+  {
+    m_n_cands = 0;
+    for (int i = 0; i < n_seeds; ++i)
+    {
+      m_seed_first[i] = -1;
+      m_seed_count[i] = 0;
+    }
+  }
+
   // eventually, protected or private
 
   int  m_idx_max, m_idx_max_prev;
-  std::vector<std::vector<IdxChi2List>> m_hits_to_add;
+
+  // New hits for all seeds of the current layer, flat SoA store.
+  // Entries of one seed are chained through m_cand_next in order of addition.
+  std::vector<int>   m_cand_seed;
+  std::vector<int>   m_cand_pos;     // position of parent in layer's candidate list
+  std::vector<int>   m_cand_trk_idx;
+  std::vector<int>   m_cand_hit_idx;
+  std::vector<float> m_cand_chi2;
+  std::vector<int>   m_cand_score;
+  std::vector<int>   m_cand_next;
+  int                m_n_cands = 0;
+
+  std::vector<int>   m_seed_first, m_seed_last, m_seed_count;
+  size_t             m_hits_capacity = 0;
+
+  // Propagated state of the current layer, one Matriplex per finder batch.
+  std::vector<MPlexLS, aligned_allocator<MPlexLS, 64>> m_prop_err;
+  std::vector<MPlexLV, aligned_allocator<MPlexLV, 64>> m_prop_par;
+  int                m_prop_pos = 0;
+
+  // Parent position in m_prop_err / m_prop_par for each entry of the Kalman update list.
+  std::vector<int>   m_kalman_update_src;
 
   EventOfCombCandidates           *mp_event_of_comb_candidates;
   std::vector<std::pair<int,int>> *mp_kalman_update_list;
-  std::vector<std::vector<Track>> *mp_extra_cands;
+  std::vector<std::vector<TrackCand>> *mp_extra_cands;
 
 #if defined(CC_TIME_ETA) or defined(CC_TIME_LAYER)
   double    t_eta, t_lay;
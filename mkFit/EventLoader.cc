@@ -0,0 +1,140 @@
+#include "EventLoader.h"
+
+#include <cassert>
+
+namespace mkfit {
+
+EventLoader::EventLoader(DataFile &data_file, const std::string &fname, int n_slots,
+                         int n_events, int first_event_id) :
+  m_data_file      (data_file),
+  m_n_events       (n_events),
+  m_first_event_id (first_event_id)
+{
+  // Mapped files are read without stdio.
+  if ( ! m_data_file.IsMapped())
+  {
+    m_fp = fopen(fname.c_str(), "r");
+    assert (m_fp != 0 && "Opening of input file failed.");
+  }
+
+  m_ready.reserve(n_slots);
+  for (int i = 0; i < n_slots; ++i)
+  {
+    m_ready.emplace_back(new EventQueue);
+  }
+}
+
+EventLoader::~EventLoader()
+{
+  if (m_thread.joinable())
+  {
+    // Wake up the loader in case it is still waiting for a free event.
+    m_to_fill.push({ nullptr, -1 });
+    m_thread.join();
+  }
+
+  if (m_fp) fclose(m_fp);
+}
+
+void EventLoader::AddEvent(int slot, std::unique_ptr<Event> ev)
+{
+  m_to_fill.push({ ev.get(), slot });
+  m_events.emplace_back(std::move(ev));
+}
+
+void EventLoader::Start()
+{
+  m_thread = std::thread(&EventLoader::loader_loop, this);
+}
+
+Event* EventLoader::Get(int slot)
+{
+  EventQueue &q = *m_ready[slot];
+  Event *ev;
+  {
+    std::unique_lock<std::mutex> lock(q.m_mutex);
+    q.m_cond.wait(lock, [&]() { return ! q.m_events.empty(); });
+    ev = q.m_events.front();
+    q.m_events.pop_front();
+  }
+  if (ev) ev->ResetValidation();
+  return ev;
+}
+
+void EventLoader::GetAsync(int slot, std::function<void(Event*)> ready)
+{
+  EventQueue &q = *m_ready[slot];
+  Event *ev;
+  {
+    std::lock_guard<std::mutex> lock(q.m_mutex);
+    if (q.m_events.empty())
+    {
+      assert ( ! q.m_waiting && "Only one GetAsync() per slot can be outstanding.");
+      q.m_waiting = std::move(ready);
+      return;
+    }
+    ev = q.m_events.front();
+    q.m_events.pop_front();
+  }
+  ready(ev);
+}
+
+void EventLoader::Recycle(int slot, Event *ev)
+{
+  m_to_fill.push({ ev, slot });
+}
+
+//------------------------------------------------------------------------------
+
+void EventLoader::loader_loop()
+{
+  for (int i = 0; i < m_n_events; ++i)
+  {
+    FillRequest req;
+    m_to_fill.pop(req);
+
+    if (req.m_event == nullptr) return;
+
+    int i_ev = i, i_file = -1;
+    if (m_data_file.HasReadOrder())
+    {
+      i_ev   = m_data_file.ReadOrderSeq(i);
+      i_file = m_data_file.SeqEventIndex(i_ev);
+    }
+
+    // The slot's Validation may still be in use by the event being
+    // processed, its maps are reset by the event thread in Get().
+    req.m_event->ResetData(m_first_event_id + i_ev);
+    req.m_event->read_in(m_data_file, m_fp, i_file);
+
+    deliver(req.m_slot, req.m_event);
+  }
+
+  for (int s = 0; s < (int) m_ready.size(); ++s)
+  {
+    deliver(s, nullptr);
+  }
+}
+
+void EventLoader::deliver(int slot, Event *ev)
+{
+  // Waiting callbacks are called without the lock, they may ask for the next
+  // event right away.
+  EventQueue &q = *m_ready[slot];
+  std::function<void(Event*)> waiting;
+  {
+    std::lock_guard<std::mutex> lock(q.m_mutex);
+    if (q.m_waiting)
+    {
+      waiting.swap(q.m_waiting);
+    }
+    else
+    {
+      q.m_events.push_back(ev);
+      q.m_cond.notify_one();
+    }
+  }
+  if (waiting) waiting(ev);
+}
+
+} // end namespace mkfit
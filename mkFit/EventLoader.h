@@ -0,0 +1,91 @@
+#ifndef EventLoader_h
+#define EventLoader_h
+
+#include "Event.h"
+
+#include "tbb/concurrent_queue.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mkfit {
+
+//==============================================================================
+// EventLoader
+//==============================================================================
+
+// Reads events from a DataFile on a dedicated thread, ahead of processing.
+//
+// Each event-processing slot owns a fixed set of pre-allocated Event objects
+// (they are bound to the slot's Validation). Free events are queued to the
+// loader which decodes the next event from file into them and passes them
+// back through the slot's ready queue. Events are recycled, their vectors
+// keep capacity so there are no reallocations in steady state.
+//
+// Faster slots return their events sooner and so get more of them -- there
+// is no static assignment of file events to slots.
+
+class EventLoader
+{
+  struct FillRequest
+  {
+    Event *m_event;
+    int    m_slot;
+  };
+
+  // Decoded events of a slot. A consumer that asks through GetAsync() when
+  // the queue is empty leaves its callback in m_waiting instead of blocking.
+  struct EventQueue
+  {
+    std::mutex                  m_mutex;
+    std::condition_variable     m_cond;
+    std::deque<Event*>          m_events;
+    std::function<void(Event*)> m_waiting;
+  };
+
+  DataFile   &m_data_file;
+  FILE       *m_fp = 0;
+  int         m_n_events;
+  int         m_first_event_id;
+
+  std::vector<std::unique_ptr<Event>>       m_events;
+  std::vector<std::unique_ptr<EventQueue>>  m_ready;
+  tbb::concurrent_bounded_queue<FillRequest> m_to_fill;
+
+  std::thread m_thread;
+
+  void loader_loop();
+  void deliver(int slot, Event *ev);
+
+public:
+  EventLoader(DataFile &data_file, const std::string &fname, int n_slots,
+              int n_events, int first_event_id);
+  ~EventLoader();
+
+  // Hand a pre-allocated event to the loader, to be used for given slot.
+  void AddEvent(int slot, std::unique_ptr<Event> ev);
+
+  void Start();
+
+  // Blocks until the next decoded event for the slot is available.
+  // Returns nullptr when all events have been read. Must be called from the
+  // slot's event thread, it resets the validation maps of the event.
+  Event* Get(int slot);
+
+  // Non-blocking Get(): calls ready(ev) right away when an event for the
+  // slot is decoded, otherwise from the loader thread once it is. Only one
+  // request per slot can be outstanding. Validation maps are not reset, the
+  // caller does it with Event::ResetValidation() when the slot's Validation
+  // is no longer in use.
+  void GetAsync(int slot, std::function<void(Event*)> ready);
+
+  void Recycle(int slot, Event *ev);
+};
+
+} // end namespace mkfit
+#endif
@@ -2,15 +2,21 @@
 
 #include "Event.h"
 
-#include "Ice/IceRevisitedRadix.h"
-
 namespace mkfit {
 
-void LayerOfHits::setup_bins(float qmin, float qmax, float dq)
+template <typename IdxT>
+void LayerOfHitsT<IdxT>::setup_bins(float qmin, float qmax, float dq, int phi_bits)
 {
-  // Define layer with min/max and number of bins along q.
+  // Define layer with min/max and number of bins along q, and number
+  // of phi bins.
+
+  assert (phi_bits > 0 && phi_bits <= m_phi_bits_fine && "Phi bits out of range.");
 
-  // XXXX MT: Could have n_phi bins per layer, too.
+  m_phi_bits       = phi_bits;
+  m_nphi           = 1 << m_phi_bits;
+  m_phi_mask       = m_nphi - 1;
+  m_phi_bits_shift = m_phi_bits_fine - m_phi_bits;
+  m_phi_fine_mask  = ~((1 << m_phi_bits_shift) - 1);
 
   if (dq < 0)
   {
@@ -28,10 +34,11 @@ void LayerOfHits::setup_bins(float qmin, float qmax, float dq)
   }
   m_fq = m_nq / (qmax - qmin); // qbin = (q_hit - m_qmin) * m_fq;
 
-  m_phi_bin_infos.resize(m_nq);
+  m_phi_bin_infos.resize(m_nq * m_nphi);
 }
 
-void LayerOfHits::SetupLayer(const LayerInfo &li)
+template <typename IdxT>
+void LayerOfHitsT<IdxT>::SetupLayer(const LayerInfo &li)
 {
   // Note, LayerInfo::m_q_bin ==>  > 0 - bin width, < 0 - number of bins
 
@@ -39,13 +46,14 @@ void LayerOfHits::SetupLayer(const LayerInfo &li)
 
   m_layer_info = &li;
 
-  if (is_barrel()) setup_bins(li.m_zmin, li.m_zmax, li.m_q_bin);
-  else             setup_bins(li.m_rin,  li.m_rout, li.m_q_bin);
+  if (is_barrel()) setup_bins(li.m_zmin, li.m_zmax, li.m_q_bin, li.m_phi_bits);
+  else             setup_bins(li.m_rin,  li.m_rout, li.m_q_bin, li.m_phi_bits);
 }
 
 //==============================================================================
 
-void LayerOfHits::SuckInHits(const HitVec &hitv)
+template <typename IdxT>
+void LayerOfHitsT<IdxT>::SuckInHits(const Hit *hits, int n_hits)
 {
   // This is now in SetupLayer()
   // // should be layer dependant
@@ -70,9 +78,11 @@ void LayerOfHits::SuckInHits(const HitVec &hitv)
 
   assert (m_nq > 0 && "SetupLayer() was not called.");
 
-  const int  size   = hitv.size();
+  const int  size   = n_hits;
   const bool is_brl = is_barrel();
 
+  assert (size <= m_max_hits && "Too many hits in layer for hit_idx_t, build with HIT_IDX_32.");
+
   if (m_capacity < size)
   {
     free_hits();
@@ -84,112 +94,95 @@ void LayerOfHits::SuckInHits(const HitVec &hitv)
     m_hit_phis.resize(size);
   }
 
-  struct HitInfo
-  {
-    float phi;
-    float q;
-    uint16_t   qbin;
-    uint16_t   phibin;
-  };
-
-  std::vector<HitInfo> ha(size);
-  std::vector<udword>     hit_qphiFines(size);
-  
+  // Counting sort on (q bin, phi bin) index. The bin table itself is used
+  // for the histogram, counting hits as .second - .first, then a prefix sum
+  // turns it into bin ranges and .second is the insertion position for the
+  // scatter pass. Within a bin hits keep their input order.
+  //
+  // The table is not cleared as a whole. Bins that got hits in the previous
+  // call are reset through the previous hit infos so that .first equals
+  // .second everywhere. The prefix pass only walks q bins that have hits
+  // now; q bins that had hits before but not now are set to { 0, 0 } so
+  // that their phi bins are consistently empty. Other q bins are left as
+  // they are. For small events most of the table is not touched.
+
+  for (const HitInfo &hi : m_hit_infos)
   {
-    for (int i =0; i < size; ++i)
-    {
-      auto const& h = hitv[i];
-      
-      HitInfo &hi = ha[i];
-      // N.1.a For phi in [-pi, pi): squashPhiMinimal(h.phi()); Apparently atan2 can round the wrong way.
-      hi.phi  = h.phi();
-      hi.q    = is_brl ? h.z() : h.r();
-      hi.qbin = std::max(std::min(static_cast<int>((hi.q - m_qmin) * m_fq), m_nq - 1), 0);
-      // N.1.b ha[j].phi is returned by atan2 and can be rounded the wrong way, resulting in bin -1 or Config::m_nphi
-      hi.phibin = GetPhiBin(hi.phi) & m_phi_mask;
-      hit_qphiFines[i] = GetPhiBinFine(hi.phi) + (hi.qbin << 16);
-    }//i < size
+    auto &pbi = phi_bin_info(hi.qbin, hi.phibin);
+    pbi.second = pbi.first;
   }
 
-  RadixSort sort;
-  sort.Sort(&hit_qphiFines[0], size);
+  m_hit_infos.resize(size);
+  m_q_bin_counts.swap(m_q_bin_counts_prev);
+  m_q_bin_counts.assign(m_nq, 0);
+  m_q_bin_counts_prev.resize(m_nq, 0);
 
-  int curr_qphi    = -1;
-  empty_q_bins(0, m_nq, 0);
-
-  for (uint16_t i = 0; i < size; ++i)
+  for (int i = 0; i < size; ++i)
   {
-    int j = sort.GetRanks()[i];
+    auto const& h = hits[i];
+
+    HitInfo &hi = m_hit_infos[i];
+    // N.1.a For phi in [-pi, pi): squashPhiMinimal(h.phi()); Apparently atan2 can round the wrong way.
+    hi.phi  = h.phi();
+    hi.q    = is_brl ? h.z() : h.r();
+    hi.qbin = std::max(std::min(static_cast<int>((hi.q - m_qmin) * m_fq), m_nq - 1), 0);
+    // N.1.b phi is returned by atan2 and can be rounded the wrong way, resulting in bin -1 or m_nphi
+    hi.phibin = GetPhiBin(hi.phi) & m_phi_mask;
+
+    ++phi_bin_info(hi.qbin, hi.phibin).second;
+    ++m_q_bin_counts[hi.qbin];
+  }
 
-    // XXXX MT: Endcap has special check - try to get rid of this!
-    // Also, WTF ... this brings in holes as pos i is not filled.
-    // If this stays I need i_offset variable.
-    /* UNCOMMENT FOR DEBUGS??
-    if ( ! is_brl && (hitv[j].r() > m_qmax || hitv[j].r() < m_qmin))
+  IdxT pos = 0;
+  for (int qb = 0; qb < m_nq; ++qb)
+  {
+    if (m_q_bin_counts[qb] == 0)
     {
-      printf("LayerOfHits::SuckInHits WARNING hit out of r boundary of disk\n"
-             "  layer %d hit %d hit_r %f limits (%f, %f)\n",
-             layer_id(), j, hitv[j].r(), m_qmin, m_qmax);
-      // Figure out of this needs to stay ... and fix it
-      // --m_size;
-      // continue;
+      if (m_q_bin_counts_prev[qb] != 0) empty_phi_bins(qb, 0, m_nphi, 0);
+      continue;
     }
-    */
-
-    // Could fix the mis-sorts. Set ha size to size + 1 and fake last entry to avoid ifs.
-
-    memcpy(&m_hits[i], &hitv[j], sizeof(Hit));
-    if (Config::usePhiQArrays)
+    for (int pb = 0; pb < m_nphi; ++pb)
     {
-      m_hit_phis[i] = ha[j].phi;
-      m_hit_qs  [i] = ha[j].q;
+      auto &pbi = phi_bin_info(qb, pb);
+      const IdxT n = pbi.second - pbi.first;
+      pbi   = { pos, pos };
+      pos  += n;
     }
+  }
 
-    const int phi_bin = ha[j].phibin;
-    const int q_bin = ha[j].qbin;
+  for (int j = 0; j < size; ++j)
+  {
+    const HitInfo &hi = m_hit_infos[j];
+
+    const int i = phi_bin_info(hi.qbin, hi.phibin).second++;
 
-    // Fill the bin info
-    const int jqphi = hit_qphiFines[j] & m_phi_fine_mask;
-    if (jqphi != curr_qphi)
+    memcpy(&m_hits[i], &hits[j], sizeof(Hit));
+    if (Config::usePhiQArrays)
     {
-      m_phi_bin_infos[q_bin][phi_bin] = {i, i};
-      curr_qphi = jqphi;
+      m_hit_phis[i] = hi.phi;
+      m_hit_qs  [i] = hi.q;
     }
-
-    m_phi_bin_infos[q_bin][phi_bin].second++;
+#ifdef HIT_SOA
+    const float *par = hits[j].posArray();
+    const float *err = hits[j].errArray();
+    float       *soa = m_hit_soa + i;
+    for (int k = 0; k < 3; ++k, soa += m_hit_soa_stride) *soa = par[k];
+    for (int k = 0; k < 6; ++k, soa += m_hit_soa_stride) *soa = err[k];
+#endif
   }
 
-
-  // Check for mis-sorts due to lost precision (not really important).
-  // float phi_prev = 0;
-  // int   bin_prev = -1;
-  // int   prev_err_idx = -1;
-  // for (int i = 0; i < size; ++i)
+  // XXXX MT: Endcap has special check - try to get rid of this!
+  // UNCOMMENT FOR DEBUGS??
+  // if ( ! is_brl && (hits[j].r() > m_qmax || hits[j].r() < m_qmin))
   // {
-  //   int j = sort.GetRanks()[i];
-  //   float phi  = ha[j].phi;
-  //   int   qbin = ha[j].qbin;
-  //   if (qbin == bin_prev && phi < phi_prev)
-  //   {
-  //     //printf("  Offset error: %5d %5d %10f %10f %5d %8f\n", i, j, phi, phi_prev, ha[j].qbin, hitv[j].q());
-  //     if (prev_err_idx == i - 1)
-  //       printf("DOUBLE Offset error: %5d %5d %10f %10f %5d %8f\n", i, j, phi, phi_prev, ha[j].qbin, hitv[j].q());
-  //     prev_err_idx = i;
-  //   }
-  //   phi_prev = phi;
-  //   bin_prev = qbin;
-  // }
-
-  // Print first couple
-  // for(int i = 0; i < 20; ++i)
-  // {
-  //   int j = sort.GetRanks()[i];
-  //
-  //   printf("%3d %3d %8f %5d %8f\n", i, j, ha[j].phi, ha[j].qbin, hitv[j].q());
+  //   printf("LayerOfHits::SuckInHits WARNING hit out of r boundary of disk\n"
+  //          "  layer %d hit %d hit_r %f limits (%f, %f)\n",
+  //          layer_id(), j, hits[j].r(), m_qmin, m_qmax);
   // }
 }
 
-void LayerOfHits::SelectHitIndices(float q, float phi, float dq, float dphi, std::vector<int>& idcs, bool isForSeeding, bool dump)
+template <typename IdxT>
+void LayerOfHitsT<IdxT>::SelectHitIndices(float q, float phi, float dq, float dphi, std::vector<int>& idcs, bool isForSeeding, bool dump)
 {
   // Sanitizes q, dq and dphi. phi is expected to be in -pi, pi.
 
@@ -227,7 +220,7 @@ void LayerOfHits::SelectHitIndices(float q, float phi, float dq, float dphi, std
     {
       int pb = pi & m_phi_mask;
 
-      for (uint16_t hi = m_phi_bin_infos[qi][pb].first; hi < m_phi_bin_infos[qi][pb].second; ++hi)
+      for (IdxT hi = phi_bin_info(qi, pb).first; hi < phi_bin_info(qi, pb).second; ++hi)
       {
         // Here could enforce some furhter selection on hits
 	if (Config::usePhiQArrays)
@@ -238,7 +231,7 @@ void LayerOfHits::SelectHitIndices(float q, float phi, float dq, float dphi, std
 	  
 	  if (dump)
 	    printf("     SHI %3d %4d %4d %5d  %6.3f %6.3f %6.4f %7.5f   %s\n",
-		   qi, pi, pb, hi,
+		   qi, pi, pb, (int) hi,
 		   m_hit_qs[hi], m_hit_phis[hi], ddq, ddphi,
 		   (ddq < dq && ddphi < dphi) ? "PASS" : "FAIL");
 	  
@@ -256,23 +249,28 @@ void LayerOfHits::SelectHitIndices(float q, float phi, float dq, float dphi, std
   }
 }
 
-void LayerOfHits::PrintBins()
+template <typename IdxT>
+void LayerOfHitsT<IdxT>::PrintBins()
 {
   for (int qb = 0; qb < m_nq; ++qb)
   {
     printf("%c bin %d\n", is_barrel() ? 'Z' : 'R', qb);
-    for (int pb = 0; pb < Config::m_nphi; ++pb)
+    for (int pb = 0; pb < m_nphi; ++pb)
     {
       if (pb % 8 == 0)
         printf(" Phi %4d: ", pb);
       printf("%5d,%4d   %s",
-             m_phi_bin_infos[qb][pb].first, m_phi_bin_infos[qb][pb].second,
+             (int) phi_bin_info(qb, pb).first, (int) phi_bin_info(qb, pb).second,
              ((pb + 1) % 8 == 0) ? "\n" : "");
     }
   }
 }
 
 
+template class LayerOfHitsT<uint16_t>;
+template class LayerOfHitsT<uint32_t>;
+
+
 //==============================================================================
 // EventOfHits
 //==============================================================================
@@ -288,14 +286,89 @@ EventOfHits::EventOfHits(TrackerInfo &trk_inf) :
 }
 
 
+//==============================================================================
+// TrackCand
+//==============================================================================
+
+TrackCand::TrackCand(const Track& o, CombCandidate* comb_cand) :
+  state_           (o.state()),
+  chi2_            (o.chi2()),
+  status_          (o.getStatus()),
+  label_           (o.label()),
+  m_comb_candidate (comb_cand)
+{
+  for (const HitOnTrack *hot = o.BeginHitsOnTrack(); hot != o.EndHitsOnTrack(); ++hot)
+  {
+    addHitIdx(hot->index, hot->layer, 0.0f);
+  }
+}
+
+bool TrackCand::hasSillyValues(bool dump, bool fix, const char* pref)
+{
+  bool is_silly = false;
+  for (int i = 0; i < LL; ++i)
+  {
+    for (int j = 0; j <= i; ++j)
+    {
+      if ((i == j && state_.errors.At(i,j) < 0) || ! std::isfinite(state_.errors.At(i,j)))
+      {
+        if ( ! is_silly)
+        {
+          is_silly = true;
+          if (dump) printf("%s (label=%d):", pref, label_);
+        }
+        if (dump) printf(" (%d,%d)=%e", i, j, state_.errors.At(i,j));
+        if (fix)  state_.errors.At(i,j) = 1;
+      }
+    }
+  }
+  if (is_silly && dump) printf("\n");
+  return is_silly;
+}
+
+Track TrackCand::exportTrack() const
+{
+  // Walk the node chain from the last hit back to the seed into an on-stack
+  // array. addHitIdx() keeps at most Config::nMaxTrkHits nodes in the chain.
+
+  HitOnTrack hots[Config::nMaxTrkHits];
+
+  for (int i = nTotalHits_ - 1, ni = lastHitIdx_; i >= 0; --i)
+  {
+    const HoTNode &hn = m_comb_candidate->m_hots[ni];
+    hots[i] = hn.m_hot;
+    ni      = hn.m_prev_idx;
+  }
+
+  Track res(state_, chi2_, label_, nTotalHits_, hots);
+  res.setStatus(status_);
+  // Found hits replaced at the hit limit still count, as in Track.
+  res.setNFoundHits(nFoundHits_);
+  return res;
+}
+
+
 //==============================================================================
 // CombCandidate
 //==============================================================================
 
+void CombCandidate::ImportSeed(const Track& seed)
+{
+  emplace_back(seed, this);
+
+  m_state           = CombCandidate::Dormant;
+  m_last_seed_layer = seed.getLastHitLyr();
+  m_seed_type       = seed.getSeedTypeForRanking();
+
+  TrackCand &cand = back();
+  cand.setSeedTypeForRanking(seed.getSeedTypeForRanking());
+  cand.setCandScore         (getScoreCand(cand));
+}
+
 void CombCandidate::MergeCandsAndBestShortOne(bool update_score, bool sort_cands)
 {
-  std::vector<Track> &finalcands = *this;
-  Track              &best_short = m_best_short_cand;
+  CombCandidate &finalcands = *this;
+  TrackCand     &best_short = m_best_short_cand;
 
   if ( ! finalcands.empty())
   {
@@ -305,7 +378,32 @@ void CombCandidate::MergeCandsAndBestShortOne(bool update_score, bool sort_cands
     }
     if (sort_cands)
     {
-      std::sort(finalcands.begin(), finalcands.end(), sortByScoreCand);
+      // Sort packed keys, then apply the permutation moving each candidate once.
+      const int n = size();
+      uint64_t  keys[s_max_capacity];
+      for (int i = 0; i < n; ++i) keys[i] = getScoreSortKey(m_cands[i].getCandScore(), i);
+      std::sort(keys, keys + n);
+
+      int src[s_max_capacity];
+      for (int i = 0; i < n; ++i) src[i] = getScoreSortKeyIdx(keys[i]);
+
+      for (int i = 0; i < n; ++i)
+      {
+        if (src[i] == i || src[i] < 0) continue;
+
+        // Follow the cycle starting at i; src[j] < 0 marks placed slots.
+        TrackCand tmp = m_cands[i];
+        int j = i;
+        while (src[j] != i)
+        {
+          m_cands[j] = m_cands[src[j]];
+          const int nj = src[j];
+          src[j] = -1;
+          j = nj;
+        }
+        m_cands[j] = tmp;
+        src[j] = -1;
+      }
     }
 
     if (best_short.getCandScore() > finalcands.back().getCandScore())
@@ -336,4 +434,45 @@ void CombCandidate::MergeCandsAndBestShortOne(bool update_score, bool sort_cands
   best_short.setCandScore( getScoreWorstPossible() );
 }
 
+void CombCandidate::CompactHots(std::vector<int> &remap)
+{
+  // Parents always precede their children in the arena so live nodes can be
+  // moved down in place in one forward pass, remapping parents on the way.
+
+  const int n = m_hots.size();
+  remap.assign(n, -1);
+
+  auto mark = [&](int ni)
+  {
+    while (ni >= 0 && remap[ni] < 0)
+    {
+      remap[ni] = 0;
+      ni = m_hots[ni].m_prev_idx;
+    }
+  };
+
+  for (int i = 0; i < m_size; ++i) mark(m_cands[i].lastCcIndex());
+
+  const bool has_short = m_best_short_cand.getCandScore() > getScoreWorstPossible();
+  if (has_short) mark(m_best_short_cand.lastCcIndex());
+
+  auto new_idx = [&](int ni) { return ni >= 0 ? remap[ni] : ni; };
+
+  int n_live = 0;
+  for (int i = 0; i < n; ++i)
+  {
+    if (remap[i] < 0) continue;
+
+    HoTNode hn = m_hots[i];
+    hn.m_prev_idx = new_idx(hn.m_prev_idx);
+    remap[i] = n_live;
+    m_hots[n_live++] = hn;
+  }
+  m_hots.resize(n_live);
+
+  for (int i = 0; i < m_size; ++i) m_cands[i].setLastCcIndex(new_idx(m_cands[i].lastCcIndex()));
+
+  if (has_short) m_best_short_cand.setLastCcIndex(new_idx(m_best_short_cand.lastCcIndex()));
+}
+
 } // end namespace mkfit
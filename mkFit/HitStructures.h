@@ -9,6 +9,7 @@
 #include "Debug.h"
 
 #include <array>
+#include <limits>
 #include <tbb/tbb.h>
 
 namespace mkfit {
@@ -36,11 +37,9 @@ typedef tbb::concurrent_vector<TripletIdx> TripletIdxConVec;
 // Need a good "array of pods" class with aligned alloc and automatic growth.
 // For now just implement the no-resize / no-destroy basics in the BoH.
 
-typedef std::pair<uint16_t, uint16_t> PhiBinInfo_t;
+template <typename IdxT> using PhiBinInfoT = std::pair<IdxT, IdxT>;
 
-typedef std::array<PhiBinInfo_t, Config::m_nphi> vecPhiBinInfo_t;
-
-typedef std::vector<vecPhiBinInfo_t> vecvecPhiBinInfo_t;
+typedef PhiBinInfoT<hit_idx_t> PhiBinInfo_t;
 
 //==============================================================================
 
@@ -59,30 +58,58 @@ inline bool sortTrksByPhiMT(const Track& t1, const Track& t2)
 
 // Note: the same code is used for barrel and endcap. In barrel the longitudinal
 // bins are in Z and in endcap they are in R -- here this coordinate is called Q
+//
+// IdxT is the type of hit indices in the bin table, see hit_idx_t.
 
-class LayerOfHits
+template <typename IdxT>
+class LayerOfHitsT
 {
 public:
+  typedef IdxT                                      hit_idx_t;
+  typedef PhiBinInfoT<IdxT>                         PhiBinInfo_t;
+  typedef std::vector<PhiBinInfo_t>                 vecPhiBinInfo_t;
+
+  // Maximum number of hits in layer, also limited by 24-bit HitOnTrack::index.
+  static constexpr int m_max_hits = std::min<long long>(std::numeric_limits<IdxT>::max(), (1 << 23) - 1);
+
   const LayerInfo          *m_layer_info = 0;
   Hit                      *m_hits = 0;
-  vecvecPhiBinInfo_t        m_phi_bin_infos;
+  vecPhiBinInfo_t           m_phi_bin_infos; // m_nq rows of m_nphi bins, see phi_bin_info()
   std::vector<float>        m_hit_phis;
   std::vector<float>        m_hit_qs;
 
+#ifdef HIT_SOA
+  // SoA copy of hit parameters (x, y, z) followed by the 6 packed error
+  // elements, ordered as in Hit::posArray() / errArray(). Each component
+  // takes m_hit_soa_stride floats. Used by MatriplexHitPackerSoA.
+  static constexpr int      m_hit_soa_size = 9;
+  float                    *m_hit_soa = 0;
+  int                       m_hit_soa_stride = 0;
+
+  const float* hit_soa_par() const { return m_hit_soa; }
+  const float* hit_soa_err() const { return m_hit_soa + 3 * m_hit_soa_stride; }
+#endif
+
   float m_qmin, m_qmax, m_fq;
   int   m_nq = 0;
   int   m_capacity = 0;
 
+  // Phi binning, from LayerInfo::m_phi_bits.
+  int   m_nphi = 0;
+  int   m_phi_mask;
+  int   m_phi_bits;
+  int   m_phi_bits_shift;
+  int   m_phi_fine_mask;
+
   int   layer_id()  const { return m_layer_info->m_layer_id;    }
   bool  is_barrel() const { return m_layer_info->is_barrel();   }
   bool  is_endcap() const { return ! m_layer_info->is_barrel(); }
-  int   bin_index(int q, int p) const { return q*Config::m_nphi + p; }
+  int   bin_index(int q, int p) const { return q*m_nphi + p; }
 
-  PhiBinInfo_t operator[](int i) const {
-    int q = i/Config::m_nphi;
-    int p = i % Config::m_nphi;
-    return m_phi_bin_infos[q][p];
-  }
+  PhiBinInfo_t operator[](int i) const { return m_phi_bin_infos[i]; }
+
+  PhiBinInfo_t&       phi_bin_info(int q, int p)       { return m_phi_bin_infos[bin_index(q, p)]; }
+  const PhiBinInfo_t& phi_bin_info(int q, int p) const { return m_phi_bin_infos[bin_index(q, p)]; }
 
   bool  is_within_z_limits(float z) const { return m_layer_info->is_within_z_limits(z); }
   bool  is_within_r_limits(float r) const { return m_layer_info->is_within_r_limits(r); }
@@ -126,24 +153,39 @@ public:
   float phif_lpt_ec() const { return m_layer_info->m_phif_lpt_ec; }
 
   // Testing bin filling
-  static constexpr float m_fphi     = Config::m_nphi / Config::TwoPI;
-  static constexpr int   m_phi_mask = 0x7f;
-  static constexpr int   m_phi_bits = 7;
+  // Phi bins are built from fine phi bins, so m_phi_bits <= m_phi_bits_fine.
   static constexpr float m_fphi_fine     =  1024 / Config::TwoPI;
   static constexpr int   m_phi_mask_fine = 0x3ff;
   static constexpr int   m_phi_bits_fine = 10;//can't be more than 16
-  static constexpr int   m_phi_bits_shift = m_phi_bits_fine - m_phi_bits;
-  static constexpr int   m_phi_fine_mask = ~((1 << m_phi_bits_shift) - 1);
 
 protected:
 
-  void setup_bins(float qmin, float qmax, float dq);
+  // Per-hit scratch of SuckInHits(), kept to avoid allocations per event.
+  struct HitInfo
+  {
+    float    phi;
+    float    q;
+    uint16_t qbin;
+    uint16_t phibin;
+  };
+
+  // Hit infos and hit counts per q bin of the last SuckInHits(), used to
+  // reset only the parts of the bin table that had hits.
+  std::vector<HitInfo> m_hit_infos;
+  std::vector<int>     m_q_bin_counts;
+  std::vector<int>     m_q_bin_counts_prev;
+
+  void setup_bins(float qmin, float qmax, float dq, int phi_bits);
 
   void alloc_hits(int size)
   {
     m_hits = (Hit*) _mm_malloc(sizeof(Hit) * size, 64);
     m_capacity = size;
     for (int ihit = 0; ihit < m_capacity; ihit++){m_hits[ihit] = Hit();} 
+#ifdef HIT_SOA
+    m_hit_soa_stride = (size + 15) & ~15;
+    m_hit_soa = (float*) _mm_malloc(sizeof(float) * m_hit_soa_size * m_hit_soa_stride, 64);
+#endif
     if (Config::usePhiQArrays)
     {
       m_hit_phis.resize(size);
@@ -154,35 +196,38 @@ protected:
   void free_hits()
   {
     _mm_free(m_hits);
+#ifdef HIT_SOA
+    _mm_free(m_hit_soa);
+#endif
   }
 
-  void set_phi_bin(int q_bin, int phi_bin, uint16_t &hit_count, uint16_t &hits_in_bin)
+  void set_phi_bin(int q_bin, int phi_bin, IdxT &hit_count, IdxT &hits_in_bin)
   {
-    m_phi_bin_infos[q_bin][phi_bin] = { hit_count, hit_count + hits_in_bin };
+    phi_bin_info(q_bin, phi_bin) = { hit_count, hit_count + hits_in_bin };
     hit_count  += hits_in_bin;
     hits_in_bin = 0;
   }
 
-  void empty_phi_bins(int q_bin, int phi_bin_1, int phi_bin_2, uint16_t hit_count)
+  void empty_phi_bins(int q_bin, int phi_bin_1, int phi_bin_2, IdxT hit_count)
   {
     for (int pb = phi_bin_1; pb < phi_bin_2; ++pb)
     {
-      m_phi_bin_infos[q_bin][pb] = { hit_count, hit_count };
+      phi_bin_info(q_bin, pb) = { hit_count, hit_count };
     }
   }
 
-  void empty_q_bins(int q_bin_1, int q_bin_2, uint16_t hit_count)
+  void empty_q_bins(int q_bin_1, int q_bin_2, IdxT hit_count)
   {
     for (int qb = q_bin_1; qb < q_bin_2; ++qb)
     {
-      empty_phi_bins(qb, 0, Config::m_nphi, hit_count);
+      empty_phi_bins(qb, 0, m_nphi, hit_count);
     }
   }
 
 public:
-  LayerOfHits() {}
+  LayerOfHitsT() {}
 
-  ~LayerOfHits()
+  ~LayerOfHitsT()
   {
     free_hits();
   }
@@ -203,15 +248,18 @@ public:
 
   int   GetPhiBinChecked(float phi) const { return GetPhiBin(phi) & m_phi_mask; }
 
-  const vecPhiBinInfo_t& GetVecPhiBinInfo(float q) const { return m_phi_bin_infos[GetQBin(q)]; }
+  const PhiBinInfo_t* GetPhiBinInfoRow(float q) const { return &phi_bin_info(GetQBin(q), 0); }
 
-  void  SuckInHits(const HitVec &hitv);
+  void  SuckInHits(const Hit *hits, int n_hits);
+  void  SuckInHits(const HitVec &hitv) { SuckInHits(hitv.data(), hitv.size()); }
 
   void  SelectHitIndices(float q, float phi, float dq, float dphi, std::vector<int>& idcs, bool isForSeeding=false, bool dump=false);
 
   void  PrintBins();
 };
 
+typedef LayerOfHitsT<hit_idx_t> LayerOfHits;
+
 //==============================================================================
 
 class EventOfHits
@@ -231,33 +279,326 @@ public:
     }
   }
 
-  void SuckInHits(int layer, const HitVec &hitv)
+  void SuckInHits(int layer, const Hit *hits, int n_hits)
   {
-    m_layers_of_hits[layer].SuckInHits(hitv);
+    m_layers_of_hits[layer].SuckInHits(hits, n_hits);
   }
 };
 
 
 
 //==============================================================================
-// CombinedCandidate and EventOfCombinedCandidates
+// TrackCand, CombinedCandidate and EventOfCombinedCandidates
 //==============================================================================
 
-// This inheritance sucks but not doing it will require more changes.
+// Hits-on-track of all candidates of a seed are stored in an append-only node
+// arena in CombCandidate. Each node points to its parent so candidates sharing
+// a history share the nodes. A candidate only holds its state, counters and
+// the index of its last node; flat hit arrays are built by exportTrack().
+
+struct HoTNode
+{
+  HitOnTrack m_hot;
+  int        m_prev_idx;
+};
+
+class CombCandidate;
+
+class TrackCand
+{
+public:
+  typedef Track::Status Status;
+
+  TrackCand() {}
+
+  // Imports all hits of the track into the arena of comb_cand.
+  TrackCand(const Track& o, CombCandidate* comb_cand);
+
+  bool  hasSillyValues(bool dump, bool fix, const char* pref="");
+
+  const SVector6&     parameters() const {return state_.parameters;}
+  const SMatrixSym66& errors()     const {return state_.errors;}
+  const TrackState&   state()      const {return state_;}
+
+  const float* posArray() const {return state_.parameters.Array();}
+  const float* errArray() const {return state_.errors.Array();}
+
+  SVector6&     parameters_nc() {return state_.parameters;}
+  SMatrixSym66& errors_nc()     {return state_.errors;}
+
+  int   charge() const {return state_.charge;}
+  float chi2()   const {return chi2_;}
+  int   label()  const {return label_;}
+
+  float x()      const { return state_.parameters[0]; }
+  float y()      const { return state_.parameters[1]; }
+  float z()      const { return state_.parameters[2]; }
+  float posEta() const { return getEta(state_.parameters[0],state_.parameters[1],state_.parameters[2]); }
+  float pT()     const { return state_.pT(); }
+  float momEta() const { return state_.momEta(); }
+
+  void setCharge(int chg)  { state_.charge = chg; }
+  void setChi2(float chi2) { chi2_ = chi2; }
+  void setLabel(int lbl)   { label_ = lbl; }
+
+  // Adds a hit node. At Config::nMaxTrkHits follows Track::addHitIdx().
+  inline void addHitIdx(int hitIdx, int hitLyr, float chi2);
+
+  inline HitOnTrack getLastHitOnTrack() const;
+  int getLastHitIdx() const { return getLastHitOnTrack().index; }
+  int getLastHitLyr() const { return getLastHitOnTrack().layer; }
 
-class CombCandidate : public std::vector<Track>
+  int  lastCcIndex()         const { return lastHitIdx_; }
+  int  nFoundHits()          const { return nFoundHits_; }
+  int  nTotalHits()          const { return nTotalHits_; }
+  int  nInsideMinusOneHits() const { return nInsideMinusOneHits_; }
+  int  nTailMinusOneHits()   const { return nTailMinusOneHits_; }
+  int  nMissingHits()        const { return nInsideMinusOneHits_; }
+
+  void setLastCcIndex(int i)         { lastHitIdx_ = i; }
+  void setNFoundHits(int n)          { nFoundHits_ = n; }
+  void setNTotalHits(int n)          { nTotalHits_ = n; }
+  void setNInsideMinusOneHits(int n) { nInsideMinusOneHits_ = n; }
+  void setNTailMinusOneHits(int n)   { nTailMinusOneHits_ = n; }
+
+  CombCandidate* combCandidate() const { return m_comb_candidate; }
+  void setCombCandidate(CombCandidate* cc) { m_comb_candidate = cc; }
+
+  Status getStatus() const { return status_; }
+
+  void setSeedTypeForRanking(unsigned int r) { status_.seed_type = r; }
+  unsigned int getSeedTypeForRanking() const { return status_.seed_type; }
+
+  void setCandScore(int r) { status_.cand_score = r; }
+  int getCandScore() const { return status_.cand_score; }
+
+  bool isStopped() const { return status_.stopped; }
+  void setStopped()      { status_.stopped = true; }
+
+  // Builds a Track with the flat hit-on-track array from the node chain.
+  Track exportTrack() const;
+
+private:
+  inline void recountMinusOneHits();
+
+  TrackState     state_;
+  float          chi2_                = 0.;
+  int            lastHitIdx_          = -1; // index of last node in m_comb_candidate->m_hots
+  short int      nFoundHits_          = 0;
+  short int      nTotalHits_          = 0;
+  short int      nInsideMinusOneHits_ = 0;  // -1 hits before the last found hit
+  short int      nTailMinusOneHits_   = 0;  // -1 hits after the last found hit
+  Status         status_;
+  int            label_               = -1;
+  CombCandidate *m_comb_candidate     = nullptr;
+};
+
+inline int getScoreCand(const TrackCand& cand1)
+{
+  unsigned int seedtype = cand1.getSeedTypeForRanking();
+  int nfoundhits = cand1.nFoundHits();
+  int nmisshits = cand1.nMissingHits();
+  float pt = cand1.pT();
+  float chi2 = cand1.chi2();
+  // Do not allow for chi2<0 in score calculation
+  if(chi2<0) chi2=0.f;
+  // Do not allow for chi2>2^14/2/10 in score calculation (see getScoreCand(const Track&))
+  if(chi2>Config::maxChi2ForRanking_) chi2=Config::maxChi2ForRanking_;
+  return getScoreCalc(seedtype,nfoundhits,nmisshits,chi2,pt);
+}
+
+inline bool sortByScoreTrackCand(const TrackCand & cand1, const TrackCand & cand2)
+{
+  return cand1.getCandScore() > cand2.getCandScore();
+}
+
+// Packs score and index into one key. Ascending key order is descending score,
+// equal scores keep index order (as a stable sort would). Sorting keys instead
+// of candidates means only indices get permuted.
+inline uint64_t getScoreSortKey(int score, int idx)
+{
+  return ((uint64_t) (0x7FFFFFFFLL - score) << 32) | (uint32_t) idx;
+}
+
+inline int getScoreSortKeyIdx(uint64_t key)
+{
+  return (int) (key & 0xFFFFFFFF);
+}
+
+
+// Candidates of a seed live in a fixed-size window of the event-wide slab
+// owned by EventOfCombCandidates. The interface follows std::vector as far
+// as it is used in finding.
+
+class CombCandidate
 {
 public:
   enum SeedState_e { Dormant = 0, Finding, Finished };
 
-  Track        m_best_short_cand;
+  // Bound on candidates per seed, for on-stack sort keys.
+  static constexpr int s_max_capacity = 64;
+
+  typedef TrackCand*       iterator;
+  typedef const TrackCand* const_iterator;
+
+  TrackCand    m_best_short_cand;
   SeedState_e  m_state           = Dormant;
   int          m_last_seed_layer = -1;
   unsigned int m_seed_type = 0;
 
+  std::vector<HoTNode> m_hots;
+
+private:
+  TrackCand   *m_cands    = nullptr;
+  int          m_size     = 0;
+  int          m_capacity = 0;
+
+public:
+  void SetSlab(TrackCand *cands, int capacity)
+  {
+    m_cands    = cands;
+    m_size     = 0;
+    m_capacity = capacity;
+  }
+
+  void Reset()
+  {
+    m_size = 0;
+    m_hots.clear();
+    m_state           = Dormant;
+    m_last_seed_layer = -1;
+    m_seed_type       = 0;
+    m_best_short_cand.setCandScore( getScoreWorstPossible() );
+  }
+
+  int  size()     const { return m_size; }
+  int  capacity() const { return m_capacity; }
+  bool empty()    const { return m_size == 0; }
+
+  TrackCand&       operator[](int i)       { return m_cands[i]; }
+  const TrackCand& operator[](int i) const { return m_cands[i]; }
+
+  TrackCand&       front()       { return m_cands[0]; }
+  const TrackCand& front() const { return m_cands[0]; }
+  TrackCand&       back()        { return m_cands[m_size - 1]; }
+  const TrackCand& back()  const { return m_cands[m_size - 1]; }
+
+  iterator       begin()       { return m_cands; }
+  iterator       end()         { return m_cands + m_size; }
+  const_iterator begin() const { return m_cands; }
+  const_iterator end()   const { return m_cands + m_size; }
+
+  void clear() { m_size = 0; }
+
+  void resize(int n)
+  {
+    assert (n <= m_capacity);
+    for (int i = m_size; i < n; ++i) new (& m_cands[i]) TrackCand;
+    m_size = n;
+  }
+
+  template<typename... Args>
+  void emplace_back(Args&&... args)
+  {
+    assert (m_size < m_capacity);
+    new (& m_cands[m_size++]) TrackCand(std::forward<Args>(args)...);
+  }
+
+  void push_back(const TrackCand& tc) { emplace_back(tc); }
+
+  void pop_back() { --m_size; }
+
+  void insert(iterator pos, const TrackCand& tc)
+  {
+    assert (m_size < m_capacity);
+    std::copy_backward(pos, end(), end() + 1);
+    *pos = tc;
+    ++m_size;
+  }
+
+  void ImportSeed(const Track& seed);
+
   void MergeCandsAndBestShortOne(bool update_score, bool sort_cands);
+
+  // Std finding appends a node for every hit passing the chi2 cut, most of
+  // them end on dropped candidates. Once the arena outgrows its reservation
+  // nodes not reachable from the current and best short candidates are
+  // removed; remap is scratch space.
+  static constexpr int s_hots_compact_size = 4 * Config::nMaxTrkHits;
+
+  void CompactHots(std::vector<int> &remap);
 };
 
+//------------------------------------------------------------------------------
+
+inline void TrackCand::addHitIdx(int hitIdx, int hitLyr, float chi2)
+{
+  std::vector<HoTNode> &hots = m_comb_candidate->m_hots;
+
+  const bool is_found = hitIdx >= 0 || hitIdx == -9;
+
+  if (nTotalHits_ < Config::nMaxTrkHits)
+  {
+    hots.push_back({ { hitIdx, hitLyr }, lastHitIdx_ });
+    lastHitIdx_ = hots.size() - 1;
+    ++nTotalHits_;
+
+    if (hitIdx >= 0)
+    {
+      nInsideMinusOneHits_ += nTailMinusOneHits_;
+      nTailMinusOneHits_    = 0;
+    }
+    else if (hitIdx == -1)
+    {
+      ++nTailMinusOneHits_;
+    }
+  }
+  else
+  {
+    // Same as Track::addHitIdx(): at the limit found and -2 hits replace the
+    // last one, others are dropped. Hole counts then follow the stored hits.
+    status_.has_non_stored_hits = true;
+
+    if (is_found || hitIdx == -2)
+    {
+      hots.push_back({ { hitIdx, hitLyr }, hots[lastHitIdx_].m_prev_idx });
+      lastHitIdx_ = hots.size() - 1;
+      recountMinusOneHits();
+    }
+  }
+
+  if (is_found)
+  {
+    ++nFoundHits_;
+    chi2_ += chi2;
+  }
+  else if (hitIdx == -2)
+  {
+    status_.stopped = true;
+  }
+}
+
+inline void TrackCand::recountMinusOneHits()
+{
+  nInsideMinusOneHits_ = nTailMinusOneHits_ = 0;
+  bool inside = false;
+  for (int ni = lastHitIdx_; ni >= 0; ni = m_comb_candidate->m_hots[ni].m_prev_idx)
+  {
+    const int idx = m_comb_candidate->m_hots[ni].m_hot.index;
+    if (idx >= 0) inside = true;
+    else if (idx == -1) ++(inside ? nInsideMinusOneHits_ : nTailMinusOneHits_);
+  }
+}
+
+inline HitOnTrack TrackCand::getLastHitOnTrack() const
+{
+  return m_comb_candidate->m_hots[lastHitIdx_].m_hot;
+}
+
+
+// All candidates of an event are stored in one aligned slab with a fixed
+// stride per seed so SlurpIn offsets over any range of seeds stay small.
+// Reset() is O(1), seed slots are re-initialized by InsertSeed().
 
 class EventOfCombCandidates
 {
@@ -267,6 +608,10 @@ public:
   int     m_capacity;
   int     m_size;
 
+private:
+  TrackCand *m_slab        = nullptr;
+  int        m_slab_stride = 0;
+
 public:
   EventOfCombCandidates(int size=0) :
     m_candidates(),
@@ -276,21 +621,37 @@ public:
     Reset(size);
   }
 
+  ~EventOfCombCandidates()
+  {
+    _mm_free(m_slab);
+  }
+
+  // The slab is owned and CombCandidates point into it: no copy or move
+  // (declaring the copy operations deleted also suppresses the moves).
+  EventOfCombCandidates(const EventOfCombCandidates&)            = delete;
+  EventOfCombCandidates& operator=(const EventOfCombCandidates&) = delete;
+
+  // Merging with the best short candidate can add one over maxCandsPerSeed.
+  static int SlabStride() { return Config::maxCandsPerSeed + 1; }
+
   void Reset(int new_capacity)
   {
-    for (int s = 0; s < m_size; ++s)
-    {
-      m_candidates[s].clear();
-    }
+    assert (SlabStride() <= CombCandidate::s_max_capacity);
 
-    if (new_capacity > m_capacity)
+    if (new_capacity > m_capacity || SlabStride() != m_slab_stride)
     {
+      new_capacity  = std::max(new_capacity, m_capacity);
+      m_slab_stride = SlabStride();
+
+      _mm_free(m_slab);
+      m_slab = (TrackCand*) _mm_malloc(sizeof(TrackCand) * new_capacity * m_slab_stride, 64);
+
       m_candidates.resize(new_capacity);
 
-      for (int s = m_capacity; s < new_capacity; ++s)
+      for (int s = 0; s < new_capacity; ++s)
       {
-        m_candidates[s].reserve(Config::maxCandsPerSeed); //we should never exceed this
-        m_candidates[s].m_best_short_cand.setCandScore( getScoreWorstPossible() );
+        m_candidates[s].SetSlab(m_slab + s * m_slab_stride, m_slab_stride);
+        m_candidates[s].m_hots.reserve(CombCandidate::s_hots_compact_size);
       }
 
       m_capacity = new_capacity;
@@ -305,13 +666,8 @@ public:
   {
     assert (m_size < m_capacity);
 
-    m_candidates[m_size].push_back(seed);
-    m_candidates[m_size].m_state           = CombCandidate::Dormant;
-    m_candidates[m_size].m_last_seed_layer = seed.getLastHitLyr();
-    m_candidates[m_size].m_seed_type = seed.getSeedTypeForRanking();
-    Track &cand = m_candidates[m_size].back();
-    cand.setSeedTypeForRanking(seed.getSeedTypeForRanking());
-    cand.setCandScore         (getScoreCand(seed));
+    m_candidates[m_size].Reset();
+    m_candidates[m_size].ImportSeed(seed);
     ++m_size;
   }
 
@@ -319,7 +675,7 @@ public:
   {
     assert (seed_index < m_size);
 
-    m_candidates[seed_index].push_back(track);
+    m_candidates[seed_index].emplace_back(track, &m_candidates[seed_index]);
   }
 };
 
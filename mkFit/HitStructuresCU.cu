@@ -16,6 +16,9 @@ void LayerOfHitsCU::copy_layer_values(const LayerOfHits &layer) {
   m_zmin = layer.m_zmin;
   m_zmax = layer.m_zmax;
   m_fz = layer.m_fz;
+  m_nphi = layer.m_nphi;
+  m_phi_mask = layer.m_phi_mask;
+  m_fphi = layer.m_nphi / Config::TwoPI;
 }
 
 
@@ -57,11 +60,11 @@ void EventOfHitsCU::reserve_all_phi_bins(const EventOfHits &event_of_hits, float
                                         event_of_hits.m_layers_of_hits.end(),
                                         [](const LayerOfHits &a, const LayerOfHits &b)
                                         {
-                                          return a.m_nz < b.m_nz;
+                                          return a.m_phi_bin_infos.size() < b.m_phi_bin_infos.size();
                                         });
-  auto m_max_nz_layer = binnest_layer->m_nz;
+  auto m_max_bins_layer = binnest_layer->m_phi_bin_infos.size();
 
-  all_phi_bin_infos.reserve(m_n_layers, m_max_nz_layer*Config::m_nphi*factor);
+  all_phi_bin_infos.reserve(m_n_layers, m_max_bins_layer*factor);
 }
 
 
@@ -83,10 +86,10 @@ void EventOfHitsCU::set_layer_bin_views(const EventOfHits& event_of_hits,
 {
   for (int i = 0; i < m_n_layers; ++i) {
     m_layers_of_hits_alloc[i].m_phi_bin_infos.set_view(all_phi_bin_infos.get_ptr_to_part(i),
-                                                       event_of_hits.m_layers_of_hits[i].m_nz * Config::m_nphi);
-    m_layers_of_hits_alloc[i].m_nz = event_of_hits.m_layers_of_hits[i].m_nz;
-    m_layers_of_hits_alloc[i].m_nz_alloc = event_of_hits.m_layers_of_hits[i].m_nz * factor;
-    m_layers_of_hits_alloc[i].m_nphi_alloc = Config::m_nphi;
+                                                       event_of_hits.m_layers_of_hits[i].m_phi_bin_infos.size());
+    m_layers_of_hits_alloc[i].m_nz = event_of_hits.m_layers_of_hits[i].m_nq;
+    m_layers_of_hits_alloc[i].m_nz_alloc = event_of_hits.m_layers_of_hits[i].m_nq * factor;
+    m_layers_of_hits_alloc[i].m_nphi_alloc = event_of_hits.m_layers_of_hits[i].m_nphi;
   }
 }
 
@@ -139,13 +142,10 @@ void EventOfHitsCU::prepare_all_host_bins(const EventOfHits& event_of_hits) {
   all_host_bins.reserve(all_phi_bin_infos.global_capacity());
 
   for (int i = 0; i < event_of_hits.m_n_layers; i++) {
+    // The layer's bin table is flat, rows of its own m_nphi bins.
     size_t offset_layer = i * all_phi_bin_infos.local_capacity();
-    for (auto j = 0; j < event_of_hits.m_layers_of_hits[i].m_nz; ++j) {
-      auto it1 = event_of_hits.m_layers_of_hits[i].m_phi_bin_infos[j].begin();
-      auto it2 = event_of_hits.m_layers_of_hits[i].m_phi_bin_infos[j].end();
-      size_t offset = offset_layer + j * Config::m_nphi;
-      std::copy(it1, it2, &all_host_bins[offset]);
-    }
+    const auto &pbis = event_of_hits.m_layers_of_hits[i].m_phi_bin_infos;
+    std::copy(pbis.begin(), pbis.end(), &all_host_bins[offset_layer]);
   }
 }
 
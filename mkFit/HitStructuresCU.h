@@ -36,12 +36,11 @@ class LayerOfHitsCU {
   float m_rmin, m_rmax, m_fr;
   int   m_nr = 0;
 
-  // This could be a parameter, layer dependent.
-  //static constexpr int   m_nphi = 1024;
-  // Testing bin filling
-  //  static constexpr int   m_nphi = 16;
-  static constexpr float m_fphi = Config::m_nphi / Config::TwoPI;
-  static constexpr int   m_phi_mask = 0x3ff;
+  // Phi binning of the layer, from LayerOfHits; bin table rows have m_nphi
+  // entries.
+  int   m_nphi = 0;
+  int   m_phi_mask = 0;
+  float m_fphi = 0;
 
   // As above
   //static constexpr float m_max_dz   = 1;
@@ -468,10 +468,11 @@ void kalmanUpdate(const MPlexLS &psErr,  const MPlexLV& psPar,
                   outErr, outPar, dummy_chi2, N_proc);
 }
 
+template<int PFE>
 void kalmanPropagateAndUpdate(const MPlexLS &psErr,  const MPlexLV& psPar, const MPlexQI &inChg,
                               const MPlexHS &msErr,  const MPlexHV& msPar,
                                     MPlexLS &outErr,       MPlexLV& outPar,
-                              const int      N_proc, const PropagationFlags propFlags)
+                              const int      N_proc)
 {
   if (Config::finding_requires_propagation_to_hit_pos)
   {
@@ -484,7 +485,7 @@ void kalmanPropagateAndUpdate(const MPlexLS &psErr,  const MPlexLV& psPar, const
       msRad.At(n, 0, 0) = std::hypot(msPar.ConstAt(n, 0, 0), msPar.ConstAt(n, 1, 0));
     }
 
-    propagateHelixToRMPlex(psErr, psPar, inChg, msRad, propErr, propPar, N_proc, propFlags);
+    propagateHelixToRMPlex<PFE>(psErr, psPar, inChg, msRad, propErr, propPar, N_proc, nullptr);
 
     kalmanOperation(KFO_Update_Params, propErr, propPar, msErr, msPar,
                     outErr, outPar, dummy_chi2, N_proc);
@@ -507,10 +508,11 @@ void kalmanComputeChi2(const MPlexLS &psErr,  const MPlexLV& psPar, const MPlexQ
                   dummy_err, dummy_par, outChi2, N_proc);
 }
 
+template<int PFE>
 void kalmanPropagateAndComputeChi2(const MPlexLS &psErr,  const MPlexLV& psPar, const MPlexQI &inChg,
                                    const MPlexHS &msErr,  const MPlexHV& msPar,
                                          MPlexQF& outChi2,
-                                   const int      N_proc, const PropagationFlags propFlags)
+                                   const int      N_proc)
 {
   if (Config::finding_requires_propagation_to_hit_pos)
   {
@@ -523,7 +525,7 @@ void kalmanPropagateAndComputeChi2(const MPlexLS &psErr,  const MPlexLV& psPar,
       msRad.At(n, 0, 0) = std::hypot(msPar.ConstAt(n, 0, 0), msPar.ConstAt(n, 1, 0));
     }
 
-    propagateHelixToRMPlex(psErr, psPar, inChg, msRad, propErr, propPar, N_proc, propFlags);
+    propagateHelixToRMPlex<PFE>(psErr, psPar, inChg, msRad, propErr, propPar, N_proc, nullptr);
 
     kalmanOperation(KFO_Calculate_Chi2, propErr, propPar, msErr, msPar,
                     dummy_err, dummy_par, outChi2, N_proc);
@@ -686,10 +688,11 @@ void kalmanUpdateEndcap(const MPlexLS &psErr,  const MPlexLV& psPar,
                         outErr, outPar, dummy_chi2, N_proc);
 }
 
+template<int PFE>
 void kalmanPropagateAndUpdateEndcap(const MPlexLS &psErr,  const MPlexLV& psPar, const MPlexQI &inChg,
                                     const MPlexHS &msErr,  const MPlexHV& msPar,
                                           MPlexLS &outErr,       MPlexLV& outPar,
-                                    const int      N_proc, const PropagationFlags propFlags)
+                                    const int      N_proc)
 {
   if (Config::finding_requires_propagation_to_hit_pos)
   {
@@ -702,7 +705,7 @@ void kalmanPropagateAndUpdateEndcap(const MPlexLS &psErr,  const MPlexLV& psPar,
       msZ.At(n, 0, 0) = msPar.ConstAt(n, 2, 0);
     }
 
-    propagateHelixToZMPlex(psErr, psPar, inChg, msZ, propErr, propPar, N_proc, propFlags);
+    propagateHelixToZMPlex<PFE>(psErr, psPar, inChg, msZ, propErr, propPar, N_proc, nullptr);
 
     kalmanOperationEndcap(KFO_Update_Params, propErr, propPar, msErr, msPar,
                           outErr, outPar, dummy_chi2, N_proc);
@@ -725,10 +728,11 @@ void kalmanComputeChi2Endcap(const MPlexLS &psErr,  const MPlexLV& psPar, const
                         dummy_err, dummy_par, outChi2, N_proc);
 }
 
+template<int PFE>
 void kalmanPropagateAndComputeChi2Endcap(const MPlexLS &psErr,  const MPlexLV& psPar, const MPlexQI &inChg,
                                          const MPlexHS &msErr,  const MPlexHV& msPar,
                                                MPlexQF& outChi2,
-                                         const int      N_proc, const PropagationFlags propFlags)
+                                         const int      N_proc)
 {
   if (Config::finding_requires_propagation_to_hit_pos)
   {
@@ -741,7 +745,7 @@ void kalmanPropagateAndComputeChi2Endcap(const MPlexLS &psErr,  const MPlexLV& p
       msZ.At(n, 0, 0) = msPar.ConstAt(n, 2, 0);
     }
 
-    propagateHelixToZMPlex(psErr, psPar, inChg, msZ, propErr, propPar, N_proc, propFlags);
+    propagateHelixToZMPlex<PFE>(psErr, psPar, inChg, msZ, propErr, propPar, N_proc, nullptr);
 
     kalmanOperationEndcap(KFO_Calculate_Chi2, propErr, propPar, msErr, msPar,
                           dummy_err, dummy_par, outChi2, N_proc);
@@ -871,4 +875,21 @@ void kalmanOperationEndcap(const int      kfOp,
   }
 }
 
+//==============================================================================
+
+#define INSTANTIATE_KALMAN_PROPAGATE(PFE) \
+  template void kalmanPropagateAndUpdate<PFE>(const MPlexLS&, const MPlexLV&, const MPlexQI&, \
+                                              const MPlexHS&, const MPlexHV&, MPlexLS&, MPlexLV&, const int); \
+  template void kalmanPropagateAndComputeChi2<PFE>(const MPlexLS&, const MPlexLV&, const MPlexQI&, \
+                                                   const MPlexHS&, const MPlexHV&, MPlexQF&, const int); \
+  template void kalmanPropagateAndUpdateEndcap<PFE>(const MPlexLS&, const MPlexLV&, const MPlexQI&, \
+                                                    const MPlexHS&, const MPlexHV&, MPlexLS&, MPlexLV&, const int); \
+  template void kalmanPropagateAndComputeChi2Endcap<PFE>(const MPlexLS&, const MPlexLV&, const MPlexQI&, \
+                                                         const MPlexHS&, const MPlexHV&, MPlexQF&, const int);
+
+INSTANTIATE_KALMAN_PROPAGATE(PF_none)
+INSTANTIATE_KALMAN_PROPAGATE(PF_use_param_b_field)
+INSTANTIATE_KALMAN_PROPAGATE(PF_apply_material)
+INSTANTIATE_KALMAN_PROPAGATE(PF_use_param_b_field | PF_apply_material)
+
 } // end namespace mkfit
@@ -26,10 +26,12 @@ void kalmanUpdate(const MPlexLS &psErr,  const MPlexLV& psPar,
                         MPlexLS &outErr,       MPlexLV& outPar,
                   const int      N_proc);
 
+// Propagating variants are specialized on PropagationFlagsEnum values for FindingFoos.
+template<int PFE>
 void kalmanPropagateAndUpdate(const MPlexLS &psErr,  const MPlexLV& psPar, const MPlexQI &inChg,
                               const MPlexHS &msErr,  const MPlexHV& msPar,
                                     MPlexLS &outErr,       MPlexLV& outPar,
-                              const int      N_proc, const PropagationFlags propFlags);
+                              const int      N_proc);
 
 
 void kalmanComputeChi2(const MPlexLS &psErr,  const MPlexLV& psPar, const MPlexQI &inChg,
@@ -37,10 +39,11 @@ void kalmanComputeChi2(const MPlexLS &psErr,  const MPlexLV& psPar, const MPlexQ
                              MPlexQF& outChi2,
                        const int      N_proc);
 
+template<int PFE>
 void kalmanPropagateAndComputeChi2(const MPlexLS &psErr,  const MPlexLV& psPar, const MPlexQI &inChg,
                                    const MPlexHS &msErr,  const MPlexHV& msPar,
                                          MPlexQF& outChi2,
-                                   const int      N_proc, const PropagationFlags propFlags);
+                                   const int      N_proc);
 
 
 void kalmanOperation(const int      kfOp,
@@ -57,10 +60,11 @@ void kalmanUpdateEndcap(const MPlexLS &psErr,  const MPlexLV& psPar,
                               MPlexLS &outErr,       MPlexLV& outPar,
                         const int      N_proc);
 
+template<int PFE>
 void kalmanPropagateAndUpdateEndcap(const MPlexLS &psErr,  const MPlexLV& psPar, const MPlexQI &inChg,
                                     const MPlexHS &msErr,  const MPlexHV& msPar,
                                           MPlexLS &outErr,       MPlexLV& outPar,
-                                    const int      N_proc, const PropagationFlags propFlags);
+                                    const int      N_proc);
 
 
 void kalmanComputeChi2Endcap(const MPlexLS &psErr,  const MPlexLV& psPar, const MPlexQI &inChg,
@@ -68,10 +72,11 @@ void kalmanComputeChi2Endcap(const MPlexLS &psErr,  const MPlexLV& psPar, const
                                    MPlexQF& outChi2,
                              const int      N_proc);
 
+template<int PFE>
 void kalmanPropagateAndComputeChi2Endcap(const MPlexLS &psErr,  const MPlexLV& psPar, const MPlexQI &inChg,
                                          const MPlexHS &msErr,  const MPlexHV& msPar,
                                                MPlexQF& outChi2,
-                                         const int      N_proc, const PropagationFlags propFlags);
+                                         const int      N_proc);
 
 
 void kalmanOperationEndcap(const int      kfOp,
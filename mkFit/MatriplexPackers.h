@@ -5,6 +5,7 @@
 
 #include "Hit.h"
 #include "Track.h"
+#include "HitStructures.h"
 
 namespace mkfit {
 
@@ -112,6 +113,19 @@ public:
       AddInput(item);
    }
 
+   // Issue L2 prefetch for parameters and errors of a track to be packed later,
+   // typically one of the next batch. Errors follow parameters in TrackState,
+   // together they span at most three cache lines.
+   static void Prefetch(const T& item)
+   {
+      const char *beg = (const char*) item.posArray();
+      const char *end = (const char*) (item.errArray() + MPlexLS::kSize - 1);
+
+      _mm_prefetch(beg, _MM_HINT_T1);
+      _mm_prefetch(beg + 64, _MM_HINT_T1);
+      _mm_prefetch(end, _MM_HINT_T1);
+   }
+
    template<typename TMerr, typename TMpar>
    void Pack(TMerr &err, TMpar &par)
    {
@@ -135,6 +149,80 @@ public:
 };
 
 
+//==============================================================================
+// MatriplexHitPackerSoA
+//==============================================================================
+
+// Gathers hits of a LayerOfHits from its SoA store (built with HIT_SOA),
+// one gather per component instead of touching whole Hit objects.
+// Inputs are references into LayerOfHits::m_hits, as for MatriplexHitPacker.
+
+#ifdef HIT_SOA
+
+class MatriplexHitPackerSoA
+{
+   alignas(64) int m_idx[NN];
+
+   const Hit   *m_hits;
+   const float *m_par;
+   const float *m_err;
+   int          m_stride;
+   int          m_pos;
+
+public:
+   MatriplexHitPackerSoA(const LayerOfHits& layer) :
+      m_hits   (layer.m_hits),
+      m_par    (layer.hit_soa_par()),
+      m_err    (layer.hit_soa_err()),
+      m_stride (layer.m_hit_soa_stride),
+      m_pos    (0)
+   {}
+
+   void Reset()        { m_pos = 0; }
+
+   void AddNullInput() { m_idx[m_pos++] = 0; }
+
+   void AddInput(const Hit& item)
+   {
+      m_idx[m_pos] = & item - m_hits;
+
+      ++m_pos;
+   }
+
+   void AddInputAt(int pos, const Hit& item)
+   {
+      while (m_pos < pos)
+      {
+         m_idx[m_pos++] = 0;
+      }
+
+      AddInput(item);
+   }
+
+   template<typename TMerr, typename TMpar>
+   void Pack(TMerr &err, TMpar &par)
+   {
+      assert (m_pos <= NN);
+
+      if (m_pos == 0)
+      {
+         return;
+      }
+
+#if defined(GATHER_INTRINSICS)
+      GATHER_IDX_LOAD(vi, m_idx);
+      err.SlurpIn(m_err, vi, sizeof(float), m_pos, m_stride);
+      par.SlurpIn(m_par, vi, sizeof(float), m_pos, m_stride);
+#else
+      err.SlurpIn(m_err, m_idx, m_pos, m_stride);
+      par.SlurpIn(m_par, m_idx, m_pos, m_stride);
+#endif
+   }
+};
+
+#endif
+
+
 //==============================================================================
 // MatriplexTrackPackerPlexify
 //==============================================================================
@@ -170,10 +258,23 @@ public:
 
 // Optionally ifdef with defines from Makefile.config
 
-using MatriplexHitPacker   = MatriplexErrParPackerSlurpIn<Hit,   float>;
-using MatriplexTrackPacker = MatriplexErrParPackerSlurpIn<Track, float>;
+using MatriplexHitPacker       = MatriplexErrParPackerSlurpIn<Hit,       float>;
+using MatriplexTrackPacker     = MatriplexErrParPackerSlurpIn<Track,     float>;
+using MatriplexTrackCandPacker = MatriplexErrParPackerSlurpIn<TrackCand, float>;
+
+using MatriplexHoTPacker       = MatriplexPackerSlurpIn<HitOnTrack>;
+
+// Packer for hits of LayerOfHits, as used in finding.
+#ifdef HIT_SOA
+using MatriplexLayerHitPacker = MatriplexHitPackerSoA;
+#else
+class MatriplexLayerHitPacker : public MatriplexHitPacker
+{
+public:
+   MatriplexLayerHitPacker(const LayerOfHits& layer) : MatriplexHitPacker(layer.m_hits[0]) {}
+};
+#endif
 
-using MatriplexHoTPacker   = MatriplexPackerSlurpIn<HitOnTrack>;
 }
 
 #endif
@@ -2,8 +2,10 @@
 #define MkBase_h
 
 #include "Matrix.h"
+#include "Matriplex/MatriplexFastMath.h"
 
 #include "PropagationMPlex.h"
+#include "TrackerInfo.h"
 
 namespace mkfit {
 
@@ -30,17 +32,18 @@ public:
 
   //----------------------------------------------------------------------------
 
-  void PropagateTracksToR(float r, const int N_proc, const PropagationFlags pf)
+  template<int PFE>
+  void PropagateTracksToR(const LayerInfo &layer, const int N_proc)
   {
     MPlexQF msRad;
 #pragma omp simd
     for (int n = 0; n < NN; ++n)
     {
-      msRad.At(n, 0, 0) = r;
+      msRad.At(n, 0, 0) = layer.m_propagate_to;
     }
 
-    propagateHelixToRMPlex(Err[iC], Par[iC], Chg, msRad,
-                           Err[iP], Par[iP], N_proc, pf);
+    propagateHelixToRMPlex<PFE>(Err[iC], Par[iC], Chg, msRad,
+                                Err[iP], Par[iP], N_proc, &layer);
   }
 
   void PropagateTracksToHitR(const MPlexHV& par, const int N_proc, const PropagationFlags pf)
@@ -58,17 +61,18 @@ public:
 
   //----------------------------------------------------------------------------
 
-  void PropagateTracksToZ(float z, const int N_proc, const PropagationFlags pf)
+  template<int PFE>
+  void PropagateTracksToZ(const LayerInfo &layer, const int N_proc)
   {
     MPlexQF msZ;
 #pragma omp simd
     for (int n = 0; n < NN; ++n)
     {
-      msZ.At(n, 0, 0) = z;
+      msZ.At(n, 0, 0) = layer.m_propagate_to;
     }
 
-    propagateHelixToZMPlex(Err[iC], Par[iC], Chg, msZ,
-                           Err[iP], Par[iP], N_proc, pf);
+    propagateHelixToZMPlex<PFE>(Err[iC], Par[iC], Chg, msZ,
+                                Err[iP], Par[iP], N_proc, &layer);
   }
 
   void PropagateTracksToHitZ(const MPlexHV& par, const int N_proc, const PropagationFlags pf)
@@ -90,9 +94,9 @@ public:
 #pragma omp simd
     for (int n = 0; n < NN; ++n)
     {
-      const float slope = std::tan(Par[iC].ConstAt(n, 5, 0));
+      const float slope = Matriplex::fast_tan(Par[iC].ConstAt(n, 5, 0));
       //      msZ.At(n, 0, 0) = ( Config::beamspotz0 + slope * ( Config::beamspotr0 - std::hypot(Par[iC].ConstAt(n, 0, 0), Par[iC].ConstAt(n, 1, 0))) + slope * slope * Par[iC].ConstAt(n, 2, 0) ) / ( 1+slope*slope); // PCA w.r.t. z0, r0
-      msZ.At(n, 0, 0) = (slope * (slope * Par[iC].ConstAt(n, 2, 0) - std::hypot(Par[iC].ConstAt(n, 0, 0), Par[iC].ConstAt(n, 1, 0)))) / (1 + slope * slope); // PCA to origin
+      msZ.At(n, 0, 0) = (slope * (slope * Par[iC].ConstAt(n, 2, 0) - hipo(Par[iC].ConstAt(n, 0, 0), Par[iC].ConstAt(n, 1, 0)))) / (1 + slope * slope); // PCA to origin
     } 
 
     propagateHelixToZMPlex(Err[iC], Par[iC], Chg, msZ,
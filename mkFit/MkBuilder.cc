@@ -26,6 +26,7 @@ ExecutionContext g_exe_ctx;
 #define CLONER(_n_) std::unique_ptr<CandCloner, decltype(retcand)> _n_(g_exe_ctx.m_cloners.GetFromPool(), retcand)
 #define FITTER(_n_) std::unique_ptr<MkFitter,   decltype(retfitr)> _n_(g_exe_ctx.m_fitters.GetFromPool(), retfitr)
 #define FINDER(_n_) std::unique_ptr<MkFinder,   decltype(retfndr)> _n_(g_exe_ctx.m_finders.GetFromPool(), retfndr)
+#define SCRATCH(_n_) std::unique_ptr<FindingScratch, decltype(retscr)> _n_(g_exe_ctx.m_scratches.GetFromPool(), retscr)
 
 namespace
 {
@@ -33,6 +34,7 @@ namespace
   auto retcand = [](CandCloner* cloner) { g_exe_ctx.m_cloners.ReturnToPool(cloner); };
   auto retfitr = [](MkFitter*   mkfttr) { g_exe_ctx.m_fitters.ReturnToPool(mkfttr); };
   auto retfndr = [](MkFinder*   mkfndr) { g_exe_ctx.m_finders.ReturnToPool(mkfndr); };
+  auto retscr  = [](FindingScratch* scr) { g_exe_ctx.m_scratches.ReturnToPool(scr); };
 
 
   // Range of indices processed within one iteration of a TBB parallel_for.
@@ -97,6 +99,68 @@ namespace
                                 std::min(m_reg_beg + NN * i.end(), m_reg_end));
     }
   };
+
+  // Adaptive seeds per task based on the total estimated amount of work to divide among all threads.
+  // With Config::finderFillLanes tasks are kept large enough to fill NN lanes -- tbb::blocked_range
+  // splits down to more than half of the grain size.
+  int adaptive_seeds_per_task(int n_seeds_total)
+  {
+    const int spt = clamp(Config::numThreadsEvents*n_seeds_total/Config::numThreadsFinder + 1, 4, Config::numSeedsPerTask);
+
+    return Config::finderFillLanes ? std::max(spt, 2 * NN - 1) : spt;
+  }
+
+  // Seed range of one eta region, unit of work of the region-flattened loops.
+  struct RegionTask
+  {
+    int m_region, m_seed_beg, m_seed_end;
+    int m_cost;
+  };
+
+  // Splits the seeds of all regions into one list of tasks of about equal cost,
+  // estimated as number of seeds times the length of the region's layer plan.
+  // Transition and endcap seeds visit more layers so their tasks get fewer seeds.
+  // Most expensive tasks are put first so the cheap ones fill the tail.
+  std::vector<RegionTask> make_region_tasks(Event *evt, const std::vector<int> &regions,
+                                            const SteeringParams *steering_params)
+  {
+    std::vector<RegionTask> tasks;
+
+    int n_seeds = 0, total_cost = 0;
+    for (int region : regions)
+    {
+      const RegionOfSeedIndices rosi(evt, region);
+      n_seeds    += rosi.count();
+      total_cost += rosi.count() * steering_params[region].m_layer_plan.size();
+    }
+    if (n_seeds == 0) return tasks;
+
+    const float task_cost = (float) adaptive_seeds_per_task(n_seeds) * total_cost / n_seeds;
+    const int   min_spt   = Config::finderFillLanes ? 2 * NN - 1 : 4;
+
+    for (int region : regions)
+    {
+      const RegionOfSeedIndices rosi(evt, region);
+      if (rosi.count() == 0) continue;
+
+      const int n_lay   = steering_params[region].m_layer_plan.size();
+      const int spt     = std::max(min_spt, (int) std::lround(task_cost / n_lay));
+      const int n_tasks = (rosi.count() + spt - 1) / spt;
+
+      // Spread remainder over tasks, as tbb::blocked_range splitting would.
+      for (int i = 0; i < n_tasks; ++i)
+      {
+        const int beg = rosi.m_reg_beg + (int) ((long long) rosi.count() *  i      / n_tasks);
+        const int end = rosi.m_reg_beg + (int) ((long long) rosi.count() * (i + 1) / n_tasks);
+        tasks.push_back({ region, beg, end, (end - beg) * n_lay });
+      }
+    }
+
+    std::stable_sort(tasks.begin(), tasks.end(),
+                     [](const RegionTask &a, const RegionTask &b) { return a.m_cost > b.m_cost; });
+
+    return tasks;
+  }
 }
 
 namespace mkfit {
@@ -149,7 +213,7 @@ namespace
   void print_seeds(const EventOfCombCandidates& event_of_comb_cands) {
     for (int iseed = 0; iseed < event_of_comb_cands.m_size; iseed++)
     {
-      print_seed2(event_of_comb_cands.m_candidates[iseed].front());
+      print_seed2(event_of_comb_cands.m_candidates[iseed].front().exportTrack());
     }
   }
 }
@@ -165,11 +229,6 @@ namespace
 
     return cand1.nFoundHits() > cand2.nFoundHits();
   }
-
-  bool sortCandByScore(const Track & cand1, const Track & cand2)
-  {
-    return mkfit::sortByScoreCand(cand1,cand2);
-  }
 }
 
 //------------------------------------------------------------------------------
@@ -184,9 +243,6 @@ MkBuilder::MkBuilder() :
   m_event(0),
   m_event_of_hits(Config::TrkInfo)
 {
-  m_fndfoos_brl = { kalmanPropagateAndComputeChi2,       kalmanPropagateAndUpdate,       &MkBase::PropagateTracksToR };
-  m_fndfoos_ec  = { kalmanPropagateAndComputeChi2Endcap, kalmanPropagateAndUpdateEndcap, &MkBase::PropagateTracksToZ };
-
   { SteeringParams &sp = m_steering_params[TrackerInfo::Reg_Endcap_Neg];
     sp.reserve_plan(3 + 3 + 6 + 18);
     sp.fill_plan(0, 2, false, true);
@@ -263,10 +319,31 @@ MkBuilder::~MkBuilder()
 // Common functions
 //------------------------------------------------------------------------------
 
+void MkBuilder::setup_finding_foos()
+{
+  // Pick kernels specialized on the finding PropagationFlags of the current geometry
+  // so no flags are checked per NN batch.
+  dispatchPropagationFlags(Config::finding_inter_layer_pflags, [&](auto inter)
+  {
+    dispatchPropagationFlags(Config::finding_intra_layer_pflags, [&](auto intra)
+    {
+      constexpr int inter_pfe = decltype(inter)::pfe;
+      constexpr int intra_pfe = decltype(intra)::pfe;
+
+      m_fndfoos_brl = { kalmanPropagateAndComputeChi2<intra_pfe>,       kalmanPropagateAndUpdate<intra_pfe>,
+                        &MkBase::PropagateTracksToR<inter_pfe> };
+      m_fndfoos_ec  = { kalmanPropagateAndComputeChi2Endcap<intra_pfe>, kalmanPropagateAndUpdateEndcap<intra_pfe>,
+                        &MkBase::PropagateTracksToZ<inter_pfe> };
+    });
+  });
+}
+
 void MkBuilder::begin_event(Event* ev, const char* build_type)
 {
   m_event     = ev;
 
+  setup_finding_foos();
+
   std::vector<Track>& simtracks = m_event->simTracks_;
   // DDDD MT: debug seed fit divergence between host / mic.
   // Use this once you know seed index + set debug in MkFitter.cc, PropagationXX.cc, KalmanUtils.cc
@@ -299,12 +376,12 @@ void MkBuilder::begin_event(Event* ev, const char* build_type)
 
   // fill vector of hits in each layer
   // XXXXMT: Does it really makes sense to multi-thread this?
-  tbb::parallel_for(tbb::blocked_range<int>(0, m_event->layerHits_.size()),
+  tbb::parallel_for(tbb::blocked_range<int>(0, m_event->nHitLayers()),
     [&](const tbb::blocked_range<int>& layers)
   {
     for (int ilay = layers.begin(); ilay < layers.end(); ++ilay)
     {
-      m_event_of_hits.SuckInHits(ilay, m_event->layerHits_[ilay]);
+      m_event_of_hits.SuckInHits(ilay, m_event->layerHits(ilay), m_event->nLayerHits(ilay));
     }
   });
 
@@ -450,7 +527,7 @@ void MkBuilder::import_seeds()
     const bool   z_dir_pos = S.pz() > 0;
 
     HitOnTrack hot = S.getLastHitOnTrack();
-    float      eta = m_event->layerHits_[hot.layer][hot.index].eta();
+    float      eta = m_event->layerHits(hot.layer)[hot.index].eta();
     // float   eta = S.momEta();
 
     // Region to be defined by propagation / intersection tests
@@ -604,7 +681,7 @@ void MkBuilder::find_seeds()
   TripletIdxConVec seed_idcs;
 
   //double time = dtime();
-  findSeedsByRoadSearch(seed_idcs,m_event_of_hits.m_layers_of_hits,m_event->layerHits_[1].size(),m_event);
+  findSeedsByRoadSearch(seed_idcs,m_event_of_hits.m_layers_of_hits,m_event->nLayerHits(1),m_event);
   //time = dtime() - time;
 
   // use this to initialize tracks
@@ -795,7 +872,7 @@ inline void MkBuilder::fit_one_seed_set(TrackVec& seedtracks, int itrack, int en
 
 void MkBuilder::map_track_hits(TrackVec & tracks)
 {
-  // map hit indices from global m_event->layerHits_[i] to hit indices in
+  // map hit indices from global m_event->layerHits(i) to hit indices in
   // structure m_event_of_hits.m_layers_of_hits[i].m_hits
 
   const int max_layer = Config::nTotalLayers;
@@ -817,9 +894,9 @@ void MkBuilder::map_track_hits(TrackVec & tracks)
     if (layer_has_hits[ilayer])
     {
       const auto & lof_m_hits = m_event_of_hits.m_layers_of_hits[ilayer].m_hits;
-      const auto   size = m_event->layerHits_[ilayer].size();
+      const int    size = m_event->nLayerHits(ilayer);
 
-      for (size_t index = 0; index < size; ++index)
+      for (int index = 0; index < size; ++index)
       {
         const auto mcHitID = lof_m_hits[index].mcHitID();
         min = std::min(min, mcHitID);
@@ -835,9 +912,9 @@ void MkBuilder::map_track_hits(TrackVec & tracks)
     if (layer_has_hits[ilayer])
     {
       const auto & lof_m_hits = m_event_of_hits.m_layers_of_hits[ilayer].m_hits;
-      const auto   size = m_event->layerHits_[ilayer].size();
+      const int    size = m_event->nLayerHits(ilayer);
 
-      for (size_t index = 0; index < size; ++index)
+      for (int index = 0; index < size; ++index)
       {
         trackHitMap[lof_m_hits[index].mcHitID()-min] = index;
       }
@@ -852,7 +929,7 @@ void MkBuilder::map_track_hits(TrackVec & tracks)
       int hitlyr = track.getHitLyr(i);
       if (hitidx >= 0)
       {
-        const auto & global_hit_vec = m_event->layerHits_[hitlyr];
+        const Hit  * global_hit_vec = m_event->layerHits(hitlyr);
         track.setHitIdx(i, trackHitMap[global_hit_vec[hitidx].mcHitID()-min]);
         // printf("YYY mapped %d/%d to %d\n", hitidx, hitlyr, trackHitMap[global_hit_vec[hitidx].mcHitID()-min]);
       }
@@ -863,7 +940,7 @@ void MkBuilder::map_track_hits(TrackVec & tracks)
 void MkBuilder::remap_track_hits(TrackVec & tracks)
 {
   // map cand hit indices from hit indices in structure
-  // m_event_of_hits.m_layers_of_hits[i].m_hits to global m_event->layerHits_[i]
+  // m_event_of_hits.m_layers_of_hits[i].m_hits to global m_event->layerHits(i)
 
   const int max_layer = Config::nTotalLayers;
 
@@ -872,9 +949,9 @@ void MkBuilder::remap_track_hits(TrackVec & tracks)
 
   for (int ilayer = 0; ilayer < max_layer; ++ilayer)
   {
-    const auto & global_hit_vec = m_event->layerHits_[ilayer];
-    const auto   size = global_hit_vec.size();
-    for (size_t index = 0; index < size; ++index)
+    const Hit  * global_hit_vec = m_event->layerHits(ilayer);
+    const int    size = m_event->nLayerHits(ilayer);
+    for (int index = 0; index < size; ++index)
     {
       const auto mcHitID = global_hit_vec[index].mcHitID();
       min = std::min(min, mcHitID);
@@ -886,9 +963,9 @@ void MkBuilder::remap_track_hits(TrackVec & tracks)
 
   for (int ilayer = 0; ilayer < max_layer; ++ilayer)
   {
-    const auto & global_hit_vec = m_event->layerHits_[ilayer];
-    const auto   size = global_hit_vec.size();
-    for (size_t index = 0; index < size; ++index)
+    const Hit  * global_hit_vec = m_event->layerHits(ilayer);
+    const int    size = m_event->nLayerHits(ilayer);
+    for (int index = 0; index < size; ++index)
     {
       trackHitMap[global_hit_vec[index].mcHitID()-min] = index;
     }
@@ -954,7 +1031,7 @@ void MkBuilder::quality_store_tracks(TrackVec& tracks)
     // take the first one!
     if ( ! eoccs.m_candidates[i].empty())
     {
-      const Track &bcand = eoccs.m_candidates[i].front();
+      const Track bcand = eoccs.m_candidates[i].front().exportTrack();
 
       if (std::isnan(bcand.chi2())) ++chi2_nan_cnt;
       if (bcand.chi2() > 500)       ++chi2_500_cnt;
@@ -1080,10 +1157,10 @@ void MkBuilder::track_print(Track &t, const char* pref)
     int idx = t.getHitIdx(ih);
     if (idx >= 0)
     {
-      const Hit &hit = m_event->layerHits_[lyr][idx];
+      const Hit &hit = m_event->layerHits(lyr)[idx];
       printf("    hit %2d lyr=%2d idx=%4d pos r=%7.3f z=% 8.3f   mc_hit=%4d mc_trk=%4d\n",
              ih, lyr, idx, hit.r(), hit.z(),
-             hit.mcHitID(), hit.mcTrackID(m_event->simHitsInfo_));
+             hit.mcHitID(), m_event->simHitInfo(hit.mcHitID()).mcTrackID());
     }
     else
       printf("    hit %2d        idx=%i\n", ih, t.getHitIdx(ih));
@@ -1633,8 +1710,7 @@ void MkBuilder::FindTracksBestHit()
 
           dcall(pre_prop_print(curr_layer, mkfndr.get()));
 
-          (mkfndr.get()->*fnd_foos.m_propagate_foo)(layer_info.m_propagate_to, curr_tridx,
-                                                    Config::finding_inter_layer_pflags);
+          (mkfndr.get()->*fnd_foos.m_propagate_foo)(layer_info, curr_tridx);
 
           dcall(post_prop_print(curr_layer, mkfndr.get()));
 
@@ -1681,9 +1757,13 @@ void MkBuilder::find_tracks_load_seeds()
 }
 
 int MkBuilder::find_tracks_unroll_candidates(std::vector<std::pair<int,int>> & seed_cand_vec,
+                                             std::vector<std::vector<TrackCand>> & held_cands,
                                              int start_seed, int end_seed,
                                              int prev_layer, bool pickup_only)
 {
+  // Stopped candidates are not unrolled. While their seed is still active they
+  // are passed on as held back candidates, so they compete for slots as before.
+
   int silly_count = 0;
 
   seed_cand_vec.clear();
@@ -1698,12 +1778,11 @@ int MkBuilder::find_tracks_unroll_candidates(std::vector<std::pair<int,int>> & s
     }
     if ( ! pickup_only && ccand.m_state == CombCandidate::Finding)
     {
-      bool active = false;
+      const int n_beg = seed_cand_vec.size();
       for (int ic = 0; ic < (int) ccand.size(); ++ic)
       {
-        if (ccand[ic].getLastHitIdx() != -2)
+        if ( ! ccand[ic].isStopped())
         {
-          active = true;
           seed_cand_vec.push_back(std::pair<int,int>(iseed,ic));
 
           if (Config::nan_n_silly_check_cands_every_layer)
@@ -1715,10 +1794,18 @@ int MkBuilder::find_tracks_unroll_candidates(std::vector<std::pair<int,int>> & s
           }
         }
       }
-      if ( ! active)
+      if ((int) seed_cand_vec.size() == n_beg)
       {
         ccand.m_state = CombCandidate::Finished;
       }
+      else if ((int) seed_cand_vec.size() - n_beg < (int) ccand.size())
+      {
+        for (int ic = 0; ic < (int) ccand.size(); ++ic)
+        {
+          if (ccand[ic].isStopped())
+            held_cands[iseed - start_seed].push_back(ccand[ic]);
+        }
+      }
     }
   }
 
@@ -1731,7 +1818,7 @@ int MkBuilder::find_tracks_unroll_candidates(std::vector<std::pair<int,int>> & s
 }
 
 void MkBuilder::find_tracks_handle_missed_layers(MkFinder *mkfndr, const LayerInfo &layer_info,
-                                                 std::vector<std::vector<Track>> &tmp_cands,
+                                                 std::vector<std::vector<TrackCand>> &tmp_cands,
                                                  const std::vector<std::pair<int,int>> &seed_cand_idx,
                                                  const int region, const int start_seed,
                                                  const int itrack, const int end)
@@ -1745,16 +1832,21 @@ void MkBuilder::find_tracks_handle_missed_layers(MkFinder *mkfndr, const LayerIn
   // can really screw you there (need a maxR in candidate?).
   for (int ti = itrack; ti < end; ++ti)
   {
-    Track      &cand = m_event_of_comb_cands.m_candidates[seed_cand_idx[ti].first][seed_cand_idx[ti].second];
+    TrackCand  &cand = m_event_of_comb_cands.m_candidates[seed_cand_idx[ti].first][seed_cand_idx[ti].second];
     WSR_Result &w    = mkfndr->XWsrResult[ti - itrack];
 
-    // XXXX-4 Low pT tracks can miss a barrel layer ... and should be stopped
+    // Low pT tracks can miss a barrel layer and will not reach any of the
+    // following ones; candidates with invalid propagated state are lost, too.
+    // Both are held back with the state before propagation and stopped.
     const float cand_r = std::hypot(mkfndr->getPar(ti - itrack, MkBase::iP, 0), mkfndr->getPar(ti - itrack, MkBase::iP, 1));
+    bool  stop   = ! std::isfinite(cand_r);
     if (region == TrackerInfo::Reg_Barrel && cand_r < layer_info.m_rin)
     {
-      // For now just fake outside ... and let logic below fix it.
       dprintf("Barrel cand propagated to r=%f ... layer is %f - %f\n", cand_r, layer_info.m_rin, layer_info.m_rout);
-
+      stop = true;
+    }
+    if (stop)
+    {
       mkfndr->XHitSize[ti - itrack] = 0;
       w.m_wsr = WSR_Outside;
     }
@@ -1767,6 +1859,7 @@ void MkBuilder::find_tracks_handle_missed_layers(MkFinder *mkfndr, const LayerIn
     {
       dprintf(" creating extra held back candidate\n");
       tmp_cands[seed_cand_idx[ti].first - start_seed].push_back(cand);
+      if (stop) tmp_cands[seed_cand_idx[ti].first - start_seed].back().setStopped();
 
       // This can fire for Standard finding when candidates from a given seed are
       // split between two iterations of the vecotrized loop over seeds as the
@@ -1801,36 +1894,32 @@ void MkBuilder::FindTracksStandard()
 
   EventOfCombCandidates &eoccs = m_event_of_comb_cands;
 
-  tbb::parallel_for_each(m_regions.begin(), m_regions.end(),
-    [&](int region)
-  {
-    const SteeringParams &st_par   = m_steering_params[region];
-    const TrackerInfo    &trk_info = Config::TrkInfo;
+  const std::vector<RegionTask> tasks = make_region_tasks(m_event, m_regions, m_steering_params);
 
-    const RegionOfSeedIndices rosi(m_event, region);
+  // loop over seed ranges of all regions
+  tbb::parallel_for(tbb::blocked_range<int>(0, tasks.size(), 1),
+    [&](const tbb::blocked_range<int>& i_tasks)
+  {
+    for (int i_task = i_tasks.begin(); i_task < i_tasks.end(); ++i_task)
+    {
+      const int region = tasks[i_task].m_region;
 
-    // adaptive seeds per task based on the total estimated amount of work to divide among all threads
-    const int adaptiveSPT = clamp(Config::numThreadsEvents*eoccs.m_size/Config::numThreadsFinder + 1, 4, Config::numSeedsPerTask);
-    dprint("adaptiveSPT " << adaptiveSPT << " fill " << rosi.count() << "/" << eoccs.m_size << " region " << region);
+      const SteeringParams &st_par   = m_steering_params[region];
+      const TrackerInfo    &trk_info = Config::TrkInfo;
 
-    // loop over seeds
-    tbb::parallel_for(rosi.tbb_blk_rng_std(adaptiveSPT),
-      [&](const tbb::blocked_range<int>& seeds)
-    {
       FINDER( mkfndr );
+      SCRATCH( scratch );
 
-      const int start_seed = seeds.begin();
-      const int end_seed   = seeds.end();
+      const int start_seed = tasks[i_task].m_seed_beg;
+      const int end_seed   = tasks[i_task].m_seed_end;
       const int n_seeds    = end_seed - start_seed;
 
-      std::vector<std::vector<Track>> tmp_cands(n_seeds);
-      for (size_t iseed = 0; iseed < tmp_cands.size(); ++iseed)
-      {
-        tmp_cands[iseed].reserve(2*Config::maxCandsPerSeed);//factor 2 seems reasonable to start with
-      }
+      //factor 2 seems reasonable to start with
+      g_exe_ctx.m_scratch_grow_count += scratch->prepare(n_seeds, 2*Config::maxCandsPerSeed);
+      if (Config::finderLaneStats) scratch->save_hots_capacity(eoccs, start_seed, end_seed);
 
-      std::vector<std::pair<int,int>> seed_cand_idx;
-      seed_cand_idx.reserve(n_seeds * Config::maxCandsPerSeed);
+      std::vector<std::vector<TrackCand>> &tmp_cands     = scratch->m_cands;
+      std::vector<std::pair<int,int>>     &seed_cand_idx = scratch->m_seed_cand_idx;
 
       auto layer_plan_it = st_par.finding_begin();
 
@@ -1853,11 +1942,13 @@ void MkBuilder::FindTracksStandard()
         const LayerInfo   &layer_info    = trk_info.m_layers[curr_layer];
         const FindingFoos &fnd_foos      = layer_info.is_barrel() ? m_fndfoos_brl : m_fndfoos_ec;
 
-        int theEndCand = find_tracks_unroll_candidates(seed_cand_idx, start_seed, end_seed,
+        int theEndCand = find_tracks_unroll_candidates(seed_cand_idx, tmp_cands, start_seed, end_seed,
                                                        prev_layer, layer_plan_it->m_pickup_only);
 
         if (layer_plan_it->m_pickup_only || theEndCand == 0) continue;
 
+        if (Config::finderLaneStats) scratch->count_lanes(curr_layer, theEndCand);
+
         // vectorized loop
         for (int itrack = 0; itrack < theEndCand; itrack += NN)
         {
@@ -1873,8 +1964,7 @@ void MkBuilder::FindTracksStandard()
           //propagate to layer
           dcall(pre_prop_print(curr_layer, mkfndr.get()));
 
-          (mkfndr.get()->*fnd_foos.m_propagate_foo)(layer_info.m_propagate_to, end - itrack,
-                                                    Config::finding_inter_layer_pflags);
+          (mkfndr.get()->*fnd_foos.m_propagate_foo)(layer_info, end - itrack);
 
           dcall(post_prop_print(curr_layer, mkfndr.get()));
 
@@ -1893,52 +1983,53 @@ void MkBuilder::FindTracksStandard()
 
         } //end of vectorized loop
 
-	// clean exceeding candidates per seed
-        for (int is = 0; is < n_seeds; ++is)
-        {
-          dprint("dump seed n " << is << " with input candidates=" << tmp_cands[is].size());
-          //std::sort(tmp_cands[is].begin(), tmp_cands[is].end(), sortCandByHitsChi2);
-          std::sort(tmp_cands[is].begin(), tmp_cands[is].end(), sortCandByScore);
-
-          // MT -- now we just copy as many as we need to below while we take out the -2 cands.
-          // if (tmp_cands[is].size() > static_cast<size_t>(Config::maxCandsPerSeed))
-          // {
-          //   dprint("erase extra candidates" << " tmp_cands[is].size()=" << tmp_cands[is].size()
-          //          << " Config::maxCandsPerSeed=" << Config::maxCandsPerSeed);
-          //   tmp_cands[is].erase(tmp_cands[is].begin() + Config::maxCandsPerSeed,
-          //                       tmp_cands[is].end());
-          // }
-          dprint("dump seed n " << is << " with output candidates=" << tmp_cands[is].size());
-        }
-
         // now swap with input candidates
+        std::vector<uint64_t> &sort_keys = scratch->m_sort_keys;
         for (int is = 0; is < n_seeds; ++is)
         {
-          if (tmp_cands[is].size() > 0)
+          std::vector<TrackCand> &tcs = tmp_cands[is];
+          if (tcs.size() > 0)
           {
+            dprint("dump seed n " << is << " with input candidates=" << tcs.size());
+
+            // Order by score through packed keys, candidates themselves are not moved.
+            sort_keys.resize(tcs.size());
+            for (size_t ii = 0; ii < tcs.size(); ++ii)
+            {
+              sort_keys[ii] = getScoreSortKey(tcs[ii].getCandScore(), ii);
+            }
+            std::sort(sort_keys.begin(), sort_keys.end());
+
             eoccs[start_seed+is].resize(0);
 
             // Put good candidates into eoccs, process -2 candidates.
             int  n_placed    = 0;
             bool first_short = true;
-            for (size_t ii = 0; ii < tmp_cands[is].size() && n_placed < Config::maxCandsPerSeed; ++ii)
+            for (size_t ii = 0; ii < tcs.size() && n_placed < Config::maxCandsPerSeed; ++ii)
             {
-              if (tmp_cands[is][ii].getLastHitIdx() != -2)
+              const TrackCand &tc = tcs[ getScoreSortKeyIdx(sort_keys[ii]) ];
+
+              if (tc.getLastHitIdx() != -2)
               {
-                eoccs[start_seed+is].emplace_back(tmp_cands[is][ii]);
+                eoccs[start_seed+is].emplace_back(tc);
                 ++n_placed;
               }
               else if (first_short)
               {
                 first_short = false;
-                if (tmp_cands[is][ii].getCandScore() > eoccs[start_seed+is].m_best_short_cand.getCandScore())
+                if (tc.getCandScore() > eoccs[start_seed+is].m_best_short_cand.getCandScore())
                 {
-                  eoccs[start_seed+is].m_best_short_cand = tmp_cands[is][ii];
+                  eoccs[start_seed+is].m_best_short_cand = tc;
                 }
               }
             }
 
             tmp_cands[is].clear();
+
+            if ((int) eoccs[start_seed+is].m_hots.size() > CombCandidate::s_hots_compact_size)
+            {
+              eoccs[start_seed+is].CompactHots(scratch->m_hot_remap);
+            }
           }
         }
 
@@ -1949,8 +2040,14 @@ void MkBuilder::FindTracksStandard()
       {
         eoccs[iseed].MergeCandsAndBestShortOne(false, false);
       }
-    }); // end parallel-for over chunk of seeds within region
-  }); // end of parallel-for-each over eta regions
+
+      if (Config::finderLaneStats)
+      {
+        g_exe_ctx.merge_lanes(*scratch);
+        g_exe_ctx.m_hots_grow_count += scratch->count_hots_growths(eoccs, start_seed, end_seed);
+      }
+    }
+  }); // end parallel-for over seed ranges of all regions
 
   // debug = false;
 }
@@ -1963,32 +2060,28 @@ void MkBuilder::FindTracksCloneEngine()
 {
   // debug = true;
 
-  EventOfCombCandidates &eoccs = m_event_of_comb_cands;
+  const std::vector<RegionTask> tasks = make_region_tasks(m_event, m_regions, m_steering_params);
 
-  tbb::parallel_for_each(m_regions.begin(), m_regions.end(),
-    [&](int region)
+  tbb::parallel_for(tbb::blocked_range<int>(0, tasks.size(), 1),
+    [&](const tbb::blocked_range<int>& i_tasks)
   {
-    const RegionOfSeedIndices rosi(m_event, region);
-
-    // adaptive seeds per task based on the total estimated amount of work to divide among all threads
-    const int adaptiveSPT = clamp(Config::numThreadsEvents*eoccs.m_size/Config::numThreadsFinder + 1, 4, Config::numSeedsPerTask);
-    dprint("adaptiveSPT " << adaptiveSPT << " fill " << rosi.count() << "/" << eoccs.m_size << " region " << region);
-
-    tbb::parallel_for(rosi.tbb_blk_rng_std(adaptiveSPT),
-      [&](const tbb::blocked_range<int>& seeds)
+    for (int i_task = i_tasks.begin(); i_task < i_tasks.end(); ++i_task)
     {
+      const RegionTask &t = tasks[i_task];
+
       CLONER( cloner );
       FINDER( mkfndr );
+      SCRATCH( scratch );
 
       // loop over layers
-      find_tracks_in_layers(*cloner, mkfndr.get(), seeds.begin(), seeds.end(), region);
-    });
+      find_tracks_in_layers(*cloner, mkfndr.get(), *scratch, t.m_seed_beg, t.m_seed_end, t.m_region);
+    }
   });
 
   // debug = false;
 }
 
-void MkBuilder::find_tracks_in_layers(CandCloner &cloner, MkFinder *mkfndr,
+void MkBuilder::find_tracks_in_layers(CandCloner &cloner, MkFinder *mkfndr, FindingScratch &scratch,
                                       const int start_seed, const int end_seed, const int region)
 {
   EventOfCombCandidates  &eoccs             = m_event_of_comb_cands;
@@ -1997,14 +2090,14 @@ void MkBuilder::find_tracks_in_layers(CandCloner &cloner, MkFinder *mkfndr,
 
   const int n_seeds = end_seed - start_seed;
 
-  std::vector<std::pair<int,int>> seed_cand_idx, seed_cand_update_idx;
-  seed_cand_idx.reserve       (n_seeds * Config::maxCandsPerSeed);
-  seed_cand_update_idx.reserve(n_seeds * Config::maxCandsPerSeed);
+  g_exe_ctx.m_scratch_grow_count += scratch.prepare(n_seeds, Config::maxCandsPerSeed);
+  if (Config::finderLaneStats) scratch.save_hots_capacity(eoccs, start_seed, end_seed);
 
-  std::vector<std::vector<Track>> extra_cands(n_seeds);
-  for (int ii = 0; ii < n_seeds; ++ii) extra_cands[ii].reserve(Config::maxCandsPerSeed);
+  std::vector<std::pair<int,int>>     &seed_cand_idx        = scratch.m_seed_cand_idx;
+  std::vector<std::pair<int,int>>     &seed_cand_update_idx = scratch.m_seed_cand_update_idx;
+  std::vector<std::vector<TrackCand>> &extra_cands          = scratch.m_cands;
 
-  cloner.begin_eta_bin(&eoccs, &seed_cand_update_idx, &extra_cands, start_seed, n_seeds);
+  g_exe_ctx.m_scratch_grow_count += cloner.begin_eta_bin(&eoccs, &seed_cand_update_idx, &extra_cands, start_seed, n_seeds);
 
   // Loop over layers, starting from after the seed.
   // Note that we do a final pass with curr_layer = -1 to update parameters
@@ -2033,7 +2126,7 @@ void MkBuilder::find_tracks_in_layers(CandCloner &cloner, MkFinder *mkfndr,
     const LayerOfHits &layer_of_hits = m_event_of_hits.m_layers_of_hits[curr_layer];
     const FindingFoos &fnd_foos      = layer_info.is_barrel() ? m_fndfoos_brl : m_fndfoos_ec;
 
-    const int theEndCand = find_tracks_unroll_candidates(seed_cand_idx, start_seed, end_seed,
+    const int theEndCand = find_tracks_unroll_candidates(seed_cand_idx, extra_cands, start_seed, end_seed,
                                                          prev_layer, pickup_only);
 
     dprintf("  Number of candidates to process: %d\n", theEndCand);
@@ -2047,6 +2140,8 @@ void MkBuilder::find_tracks_in_layers(CandCloner &cloner, MkFinder *mkfndr,
 
     if (pickup_only || theEndCand == 0) continue;
 
+    if (Config::finderLaneStats) scratch.count_lanes(curr_layer, theEndCand);
+
     cloner.begin_layer(curr_layer);
 
     //vectorized loop
@@ -2071,8 +2166,7 @@ void MkBuilder::find_tracks_in_layers(CandCloner &cloner, MkFinder *mkfndr,
 #endif
 
       // propagate to current layer
-      (mkfndr->*fnd_foos.m_propagate_foo)(layer_info.m_propagate_to, end - itrack,
-                                          Config::finding_inter_layer_pflags);
+      (mkfndr->*fnd_foos.m_propagate_foo)(layer_info, end - itrack);
 
       dprint("now get hit range");
 
@@ -2085,8 +2179,8 @@ void MkBuilder::find_tracks_in_layers(CandCloner &cloner, MkFinder *mkfndr,
       //std::cout << "MX number of hits in window in layer " << curr_layer << " is " <<  mkfndr->getXHitEnd(0, 0, 0)-mkfndr->getXHitBegin(0, 0, 0) << std::endl;
       // }
 
-      // copy_out the propagated track params, errors only.
-      mkfndr->CopyOutParErr(eoccs.m_candidates, end - itrack, true);
+      // keep the propagated track params, errors; cloner reads them from there.
+      cloner.store_propagated(itrack, mkfndr->Err[MkBase::iP], mkfndr->Par[MkBase::iP]);
 
       dprint("make new candidates");
       cloner.begin_iteration();
@@ -2107,8 +2201,10 @@ void MkBuilder::find_tracks_in_layers(CandCloner &cloner, MkFinder *mkfndr,
     {
       const int end = std::min(itrack + NN, theEndUpdater);
 
-      mkfndr->InputTracksAndHitIdx(eoccs.m_candidates, seed_cand_update_idx,
-                                   itrack, end, true);
+      mkfndr->InputTracksForUpdate(eoccs.m_candidates, seed_cand_update_idx,
+                                   cloner.m_kalman_update_src,
+                                   cloner.m_prop_err.data(), cloner.m_prop_par.data(),
+                                   itrack, end);
 
       mkfndr->UpdateWithLastHit(layer_of_hits, end - itrack, fnd_foos);
 
@@ -2142,6 +2238,12 @@ void MkBuilder::find_tracks_in_layers(CandCloner &cloner, MkFinder *mkfndr,
   {
     eoccs[iseed].MergeCandsAndBestShortOne(true, true);
   }
+
+  if (Config::finderLaneStats)
+  {
+    g_exe_ctx.merge_lanes(scratch);
+    g_exe_ctx.m_hots_grow_count += scratch.count_hots_growths(eoccs, start_seed, end_seed);
+  }
 }
 
 
@@ -2158,8 +2260,7 @@ void MkBuilder::FindTracksFV()
   {
     const RegionOfSeedIndices rosi(m_event, region);
 
-    // adaptive seeds per task based on the total estimated amount of work to divide among all threads
-    const int adaptiveSPT = clamp(Config::numThreadsEvents*eoccs.m_size/Config::numThreadsFinder + 1, 4, Config::numSeedsPerTask);
+    const int adaptiveSPT = adaptive_seeds_per_task(eoccs.m_size);
     dprint("adaptiveSPT " << adaptiveSPT << " fill " << rosi.count() << "/" << eoccs.m_size << " region " << region);
 
     tbb::parallel_for(rosi.tbb_blk_rng_std(adaptiveSPT),
@@ -2191,7 +2292,7 @@ void MkBuilder::find_tracks_in_layersFV(int start_seed, int end_seed, int region
   for (int index = 0; index < nMplx; ++index) {
     for (int offset = 0; offset < MkFinderFv::Seeds; ++offset) {
       dprint("seed " << iseed << " index " << index << " offset " << offset);
-      finders[index].InputTrack(eoccs.m_candidates[iseed][0], iseed, offset, false);
+      finders[index].InputTrack(eoccs.m_candidates[iseed][0].exportTrack(), iseed, offset, false);
       ++iseed;
       iseed = std::min(iseed, end_seed-1);
     }
@@ -2233,7 +2334,7 @@ void MkBuilder::find_tracks_in_layersFV(int start_seed, int end_seed, int region
       auto& mkfndr = finders[index];
 
       // propagate to current layer
-      (mkfndr.*fnd_foos.m_propagate_foo)(layer_info.m_propagate_to, mkfndr.nnfv(), Config::finding_inter_layer_pflags);
+      (mkfndr.*fnd_foos.m_propagate_foo)(layer_info, mkfndr.nnfv());
 
       mkfndr.SelectHitIndices(layer_of_hits);
 
@@ -2257,7 +2358,10 @@ void MkBuilder::find_tracks_in_layersFV(int start_seed, int end_seed, int region
     auto& mkf = finders[index];
     auto best = mkf.BestCandidate(offset);
     if (best >= 0) {
-      mkf.OutputTrack(eoccs.m_candidates[iseed], 0, best, true);
+      Track track = eoccs.m_candidates[iseed][0].exportTrack();
+      mkf.OutputTrack(track, best, true);
+      eoccs.m_candidates[iseed].Reset();
+      eoccs.InsertTrack(track, iseed);
     }
   }
 #endif
@@ -2355,24 +2459,19 @@ void MkBuilder::fit_cands_BH(MkFinder *mkfndr, int start_cand, int end_cand, int
 
 void MkBuilder::BackwardFit()
 {
-  EventOfCombCandidates &eoccs = m_event_of_comb_cands;
+  const std::vector<RegionTask> tasks = make_region_tasks(m_event, m_regions, m_steering_params);
 
-  tbb::parallel_for_each(m_regions.begin(), m_regions.end(),
-    [&](int region)
+  tbb::parallel_for(tbb::blocked_range<int>(0, tasks.size(), 1),
+    [&](const tbb::blocked_range<int>& i_tasks)
   {
-    const RegionOfSeedIndices rosi(m_event, region);
-
-    // adaptive seeds per task based on the total estimated amount of work to divide among all threads
-    const int adaptiveSPT = clamp(Config::numThreadsEvents*eoccs.m_size/Config::numThreadsFinder + 1, 4, Config::numSeedsPerTask);
-    dprint("adaptiveSPT " << adaptiveSPT << " fill " << rosi.count() << "/" << eoccs.m_size << " region " << region);
-
-    tbb::parallel_for(rosi.tbb_blk_rng_std(adaptiveSPT),
-      [&](const tbb::blocked_range<int>& cands)
+    for (int i_task = i_tasks.begin(); i_task < i_tasks.end(); ++i_task)
     {
+      const RegionTask &t = tasks[i_task];
+
       FINDER( mkfndr );
 
-      fit_cands(mkfndr.get(), cands.begin(), cands.end(), region);
-    });
+      fit_cands(mkfndr.get(), t.m_seed_beg, t.m_seed_end, t.m_region);
+    }
   });
 }
 
@@ -2381,28 +2480,11 @@ void MkBuilder::fit_cands(MkFinder *mkfndr, int start_cand, int end_cand, int re
   EventOfCombCandidates &eoccs  = m_event_of_comb_cands;
   const SteeringParams  &st_par = m_steering_params[region];
 
-  int step;
-  for (int icand = start_cand; icand < end_cand; icand += step)
+  // Candidates live in one slab (see EventOfCombCandidates) so SlurpIn offsets
+  // are always in range and full NN batches can be used.
+  for (int icand = start_cand; icand < end_cand; icand += NN)
   {
-    int end  = std::min(icand + NN, end_cand);
-
-    // Check if we need to fragment this for SlurpIn to work.
-    step = NN;
-    {
-       int end_c = icand + 1;
-       while (end_c < end)
-       {
-          // Still crashes with 0x1fffffff and 0x1ffffff, 0x1fffff works (~2000 breaks over 5k high PU events)
-          if (std::abs(&eoccs[icand][0] - &eoccs[end_c][0]) > 0x1fffff)
-          {
-             if(!Config::silent) printf("XXYZZ MkBuilder::fit_cands Breaking up candidates with offset outside of 32-bit range.\n");
-             end  = end_c;
-             step = end - icand;
-             break;
-          }
-          ++end_c;
-       }
-    }
+    const int end = std::min(icand + NN, end_cand);
 
     // printf("Pre Final fit for %d - %d\n", icand, end);
     // for (int i = icand; i < end; ++i) { const Track &t = eoccs[i][0];
@@ -12,6 +12,7 @@
 #include "MkFinderFV.h"
 #include "SteeringParams.h"
 
+#include <atomic>
 #include <functional>
 #include <mutex>
 
@@ -30,6 +31,77 @@ class LayerInfo;
 
 using MkFinderFvVec = std::vector<MkFinderFv, aligned_allocator<MkFinderFv, 64>>;
 
+// Per-task temporaries of combinatorial finding. Pooled in ExecutionContext,
+// buffers only grow and are reused across tasks and events.
+struct FindingScratch
+{
+  std::vector<std::vector<TrackCand>> m_cands; // tmp_cands (Std) or extra_cands (CE), per seed
+  std::vector<std::pair<int,int>>     m_seed_cand_idx;
+  std::vector<std::pair<int,int>>     m_seed_cand_update_idx;
+  std::vector<uint64_t>               m_sort_keys; // packed score keys of one seed (Std)
+  std::vector<int>                    m_hot_remap; // node remap for CombCandidate::CompactHots (Std)
+  std::vector<size_t>                 m_hots_capacity; // per-seed hit-node arena capacity at task start
+
+  size_t m_capacity = 0;
+
+  // Lane utilization of finding batches of the current task, per layer. Only
+  // filled with Config::finderLaneStats, merged by ExecutionContext::merge_lanes().
+  static constexpr int s_max_lane_stat_layers = 128;
+  long long m_lane_cands  [s_max_lane_stat_layers] {};
+  long long m_lane_batches[s_max_lane_stat_layers] {};
+
+  void count_lanes(int layer, int n_cands)
+  {
+    assert (layer < s_max_lane_stat_layers);
+    m_lane_cands  [layer] += n_cands;
+    m_lane_batches[layer] += (n_cands + NN - 1) / NN;
+  }
+
+  // Remembers capacities of the seeds' hit-node arenas; count_hots_growths()
+  // returns the number of them that had to grow since. Only used with
+  // Config::finderLaneStats.
+  void save_hots_capacity(const EventOfCombCandidates &eoccs, int start_seed, int end_seed)
+  {
+    m_hots_capacity.resize(end_seed - start_seed);
+    for (int s = start_seed; s < end_seed; ++s)
+      m_hots_capacity[s - start_seed] = eoccs.m_candidates[s].m_hots.capacity();
+  }
+
+  int count_hots_growths(const EventOfCombCandidates &eoccs, int start_seed, int end_seed) const
+  {
+    int n = 0;
+    for (int s = start_seed; s < end_seed; ++s)
+      n += eoccs.m_candidates[s].m_hots.capacity() > m_hots_capacity[s - start_seed];
+    return n;
+  }
+
+  // Returns 1 if any buffer had to grow since the previous call.
+  int prepare(int n_seeds, int n_cands_per_seed)
+  {
+    if ((int) m_cands.size() < n_seeds) m_cands.resize(n_seeds);
+
+    for (int i = 0; i < n_seeds; ++i)
+    {
+      m_cands[i].clear();
+      m_cands[i].reserve(n_cands_per_seed);
+    }
+
+    m_seed_cand_idx.clear();
+    m_seed_cand_idx.reserve(n_seeds * Config::maxCandsPerSeed);
+    m_seed_cand_update_idx.clear();
+    m_seed_cand_update_idx.reserve(n_seeds * Config::maxCandsPerSeed);
+    m_sort_keys.reserve(n_cands_per_seed);
+
+    size_t cap = m_cands.capacity() + m_seed_cand_idx.capacity() + m_seed_cand_update_idx.capacity() +
+                 m_sort_keys.capacity() + m_hot_remap.capacity();
+    for (auto &c : m_cands) cap += c.capacity();
+
+    const int grew = cap > m_capacity;
+    m_capacity = cap;
+    return grew;
+  }
+};
+
 struct ExecutionContext
 {
   ExecutionContext() {}
@@ -37,16 +109,44 @@ struct ExecutionContext
     dprint("MkFinderFvVec count " << m_finderv.unsafe_size());
   }
 
-  Pool<CandCloner> m_cloners;
-  Pool<MkFitter>   m_fitters;
-  Pool<MkFinder>   m_finders;
+  Pool<CandCloner>     m_cloners;
+  Pool<MkFitter>       m_fitters;
+  Pool<MkFinder>       m_finders;
+  Pool<FindingScratch> m_scratches;
   tbb::concurrent_queue<MkFinderFvVec> m_finderv;
 
+  // Number of times pooled finding scratch buffers had to grow. Stays
+  // constant once all pooled objects have seen a large enough task.
+  std::atomic<long long> m_scratch_grow_count {0};
+
+  // Number of per-seed CombCandidate::m_hots arenas that had to grow during
+  // finding. Only counted with Config::finderLaneStats.
+  std::atomic<long long> m_hots_grow_count {0};
+
+  // Lane utilization of finding batches (Std and CE), per layer: number of
+  // candidates processed and number of NN-wide batches they were packed into.
+  static constexpr int s_max_lane_stat_layers = FindingScratch::s_max_lane_stat_layers;
+  std::atomic<long long> m_lane_cands  [s_max_lane_stat_layers] {};
+  std::atomic<long long> m_lane_batches[s_max_lane_stat_layers] {};
+
+  // Adds lane counts of a finished task and clears them in the scratch.
+  void merge_lanes(FindingScratch &s)
+  {
+    for (int l = 0; l < s_max_lane_stat_layers; ++l)
+    {
+      if (s.m_lane_batches[l] == 0) continue;
+      m_lane_cands  [l] += s.m_lane_cands  [l];
+      m_lane_batches[l] += s.m_lane_batches[l];
+      s.m_lane_cands[l] = s.m_lane_batches[l] = 0;
+    }
+  }
+
   void populate(int n_thr)
   {
-    m_cloners.populate(n_thr - m_cloners.size());
-    m_fitters.populate(n_thr - m_fitters.size());
-    m_finders.populate(n_thr - m_finders.size());
+    m_cloners  .populate(n_thr - m_cloners.size());
+    m_fitters  .populate(n_thr - m_fitters.size());
+    m_finders  .populate(n_thr - m_finders.size());
+    m_scratches.populate(n_thr - m_scratches.size());
   }
 
   void populate_finderv(int n_thr, int n_seedsPerThread)
@@ -93,6 +193,7 @@ class MkBuilder
 protected:
   void fit_one_seed_set(TrackVec& simtracks, int itrack, int end, MkFitter *mkfttr,
                         const bool is_brl[]);
+  void setup_finding_foos();
 
   Event                 *m_event;
   EventOfHits            m_event_of_hits;
@@ -151,8 +252,8 @@ public:
 
   // --------
 
-  void map_track_hits  (TrackVec & tracks); // m_event->layerHits_ -> m_event_of_hits.m_layers_of_hits
-  void remap_track_hits(TrackVec & tracks); // m_event_of_hits.m_layers_of_hits -> m_event->layerHits_
+  void map_track_hits  (TrackVec & tracks); // m_event->layerHits() -> m_event_of_hits.m_layers_of_hits
+  void remap_track_hits(TrackVec & tracks); // m_event_of_hits.m_layers_of_hits -> m_event->layerHits()
 
   void quality_val();
   void quality_reset();
@@ -182,16 +283,17 @@ public:
   void find_tracks_load_seeds();
 
   int  find_tracks_unroll_candidates(std::vector<std::pair<int,int>> & seed_cand_vec,
+                                     std::vector<std::vector<TrackCand>> & held_cands,
                                      int start_seed, int end_seed,
                                      int prev_layer, bool pickup_only);
 
   void find_tracks_handle_missed_layers(MkFinder *mkfndr, const LayerInfo &layer_info,
-                                        std::vector<std::vector<Track>> &tmp_cands,
+                                        std::vector<std::vector<TrackCand>> &tmp_cands,
                                         const std::vector<std::pair<int,int>> &seed_cand_idx,
                                         const int region, const int start_seed,
                                         const int itrack, const int end);
 
-  void find_tracks_in_layers(CandCloner &cloner, MkFinder *mkfndr,
+  void find_tracks_in_layers(CandCloner &cloner, MkFinder *mkfndr, FindingScratch &scratch,
                              const int start_seed, const int end_seed, const int region);
   void find_tracks_in_layersFV(int start_seed, int end_seed, int region);
 
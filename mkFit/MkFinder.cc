@@ -27,10 +27,21 @@ void MkFinder::InputTracksAndHitIdx(const std::vector<Track>& tracks,
 
   const int iI = inputProp ? iP : iC;
 
+  MatriplexTrackPacker mtp(tracks[beg]);
+
   for (int i = beg, imp = 0; i < end; ++i, ++imp)
   {
-    copy_in(tracks[i], imp, iI);
+    copy_in_no_state(tracks[i], imp);
+    mtp.AddInput(tracks[i]);
   }
+
+  const int next_end = std::min(end + NN, (int) tracks.size());
+  for (int i = end; i < next_end; ++i)
+  {
+    MatriplexTrackPacker::Prefetch(tracks[i]);
+  }
+
+  mtp.Pack(Err[iI], Par[iI]);
 }
 
 void MkFinder::InputTracksAndHitIdx(const std::vector<Track>& tracks,
@@ -44,10 +55,25 @@ void MkFinder::InputTracksAndHitIdx(const std::vector<Track>& tracks,
 
   const int iI = inputProp ? iP : iC;
 
-  for (int i = beg, imp = mp_offset; i < end; ++i, ++imp)
+  if (mp_offset > 0)
+  {
+    // Appending to a partially filled batch, gathers would overwrite lanes below mp_offset.
+    for (int i = beg, imp = mp_offset; i < end; ++i, ++imp)
+    {
+      copy_in(tracks[idxs[i]], imp, iI);
+    }
+    return;
+  }
+
+  MatriplexTrackPacker mtp(tracks[idxs[beg]]);
+
+  for (int i = beg, imp = 0; i < end; ++i, ++imp)
   {
-    copy_in(tracks[idxs[i]], imp, iI);
+    copy_in_no_state(tracks[idxs[i]], imp);
+    mtp.AddInput(tracks[idxs[i]]);
   }
+
+  mtp.Pack(Err[iI], Par[iI]);
 }
 
 void MkFinder::InputTracksAndHitIdx(const std::vector<CombCandidate>     & tracks,
@@ -61,16 +87,27 @@ void MkFinder::InputTracksAndHitIdx(const std::vector<CombCandidate>     & track
 
   const int iI = inputProp ? iP : iC;
 
+  MatriplexTrackCandPacker mtp(tracks[idxs[beg].first][idxs[beg].second]);
+
   for (int i = beg, imp = 0; i < end; ++i, ++imp)
   {
-    const Track &trk = tracks[idxs[i].first][idxs[i].second];
+    const TrackCand &trk = tracks[idxs[i].first][idxs[i].second];
+
+    copy_in_no_state(trk, imp);
+    mtp.AddInput(trk);
 
-    copy_in(trk, imp, iI);
-    
     SeedType(imp, 0, 0) = tracks[idxs[i].first].m_seed_type;
     SeedIdx(imp, 0, 0) = idxs[i].first;
     CandIdx(imp, 0, 0) = idxs[i].second;
   }
+
+  const int next_end = std::min(end + NN, (int) idxs.size());
+  for (int i = end; i < next_end; ++i)
+  {
+    MatriplexTrackCandPacker::Prefetch(tracks[idxs[i].first][idxs[i].second]);
+  }
+
+  mtp.Pack(Err[iI], Par[iI]);
 }
 
 void MkFinder::InputTracksAndHitIdx(const std::vector<CombCandidate>                       & tracks,
@@ -84,16 +121,51 @@ void MkFinder::InputTracksAndHitIdx(const std::vector<CombCandidate>
 
   const int iI = inputProp ? iP : iC;
 
+  MatriplexTrackCandPacker mtp(tracks[idxs[beg].first][idxs[beg].second.trkIdx]);
+
   for (int i = beg, imp = 0; i < end; ++i, ++imp)
   {
-    const Track &trk = tracks[idxs[i].first][idxs[i].second.trkIdx];
+    const TrackCand &trk = tracks[idxs[i].first][idxs[i].second.trkIdx];
 
-    copy_in(trk, imp, iI);
+    copy_in_no_state(trk, imp);
+    mtp.AddInput(trk);
 
     SeedType(imp, 0, 0) = tracks[idxs[i].first].m_seed_type;
     SeedIdx(imp, 0, 0) = idxs[i].first;
     CandIdx(imp, 0, 0) = idxs[i].second.trkIdx;
   }
+
+  const int next_end = std::min(end + NN, (int) idxs.size());
+  for (int i = end; i < next_end; ++i)
+  {
+    MatriplexTrackCandPacker::Prefetch(tracks[idxs[i].first][idxs[i].second.trkIdx]);
+  }
+
+  mtp.Pack(Err[iI], Par[iI]);
+}
+
+void MkFinder::InputTracksForUpdate(const std::vector<CombCandidate>& tracks,
+                                    const std::vector<std::pair<int,int>>& idxs,
+                                    const std::vector<int>& src_pos,
+                                    const MPlexLS *prop_err, const MPlexLV *prop_par,
+                                    int beg, int end)
+{
+  // Only what UpdateWithLastHit() needs, plus indices for CopyOutParErr().
+
+  for (int i = beg, imp = 0; i < end; ++i, ++imp)
+  {
+    const TrackCand &trk = tracks[idxs[i].first][idxs[i].second];
+
+    const int b = src_pos[i] / NN, l = src_pos[i] % NN;
+    Err[iP].CopyIn(imp, prop_err[b], l);
+    Par[iP].CopyIn(imp, prop_par[b], l);
+
+    Chg    (imp, 0, 0) = trk.charge();
+    LastHoT[imp]       = trk.getLastHitOnTrack();
+
+    SeedIdx(imp, 0, 0) = idxs[i].first;
+    CandIdx(imp, 0, 0) = idxs[i].second;
+  }
 }
 
 void MkFinder::OutputTracksAndHitIdx(std::vector<Track>& tracks,
@@ -125,6 +197,50 @@ void MkFinder::OutputTracksAndHitIdx(std::vector<Track>& tracks,
   }
 }
 
+//------------------------------------------------------------------------------
+
+void MkFinder::copy_in(const TrackCand& trk, const int mslot, const int tslot)
+{
+  Err[tslot].CopyIn(mslot, trk.errArray());
+  Par[tslot].CopyIn(mslot, trk.posArray());
+
+  copy_in_no_state(trk, mslot);
+}
+
+void MkFinder::copy_in_no_state(const TrackCand& trk, const int mslot)
+{
+  Chg  (mslot, 0, 0) = trk.charge();
+  Chi2 (mslot, 0, 0) = trk.chi2();
+  Label(mslot, 0, 0) = trk.label();
+
+  NHits              (mslot, 0, 0) = trk.nTotalHits();
+  NFoundHits         (mslot, 0, 0) = trk.nFoundHits();
+  NInsideMinusOneHits(mslot, 0, 0) = trk.nInsideMinusOneHits();
+  NTailMinusOneHits  (mslot, 0, 0) = trk.nTailMinusOneHits();
+  LastHitCcIndex     (mslot, 0, 0) = trk.lastCcIndex();
+
+  LastHoT [mslot] = trk.getLastHitOnTrack();
+  CombCand[mslot] = trk.combCandidate();
+}
+
+void MkFinder::copy_out(TrackCand& trk, const int mslot, const int tslot) const
+{
+  Err[tslot].CopyOut(mslot, trk.errors_nc().Array());
+  Par[tslot].CopyOut(mslot, trk.parameters_nc().Array());
+
+  trk.setCharge(Chg  (mslot, 0, 0));
+  trk.setChi2  (Chi2 (mslot, 0, 0));
+  trk.setLabel (Label(mslot, 0, 0));
+
+  trk.setNTotalHits         (NHits              (mslot, 0, 0));
+  trk.setNFoundHits         (NFoundHits         (mslot, 0, 0));
+  trk.setNInsideMinusOneHits(NInsideMinusOneHits(mslot, 0, 0));
+  trk.setNTailMinusOneHits  (NTailMinusOneHits  (mslot, 0, 0));
+  trk.setLastCcIndex        (LastHitCcIndex     (mslot, 0, 0));
+
+  trk.setCombCandidate(CombCand[mslot]);
+}
+
 
 //==============================================================================
 // getHitSelDynamicWindows
@@ -171,6 +287,93 @@ void MkFinder::getHitSelDynamicWindows(const LayerOfHits &layer_of_hits, const f
 // SelectHitIndices
 //==============================================================================
 
+namespace
+{
+#if defined(MIC_INTRINSICS)
+  constexpr int k_select_hits_vec_width = 16;
+#elif defined(AVX2_INTRINSICS)
+  constexpr int k_select_hits_vec_width = 8;
+#else
+  constexpr int k_select_hits_vec_width = 1;
+#endif
+
+  // Appends indices of hits in [h1, h2) that pass the q and phi window
+  // checks of the scalar loop below to idcs[n ...], returns the new count.
+  // Stops once MkFinder::MPlexHitIdxMax hits are collected, but can write
+  // (and count) up to k_select_hits_vec_width - 1 entries past it.
+
+  int select_hits_in_range(const float *hqs, const float *hphis, int h1, int h2,
+                           float q, float dq, float phi, float dphi, int *idcs, int n)
+  {
+    int hi = h1;
+
+#if defined(MIC_INTRINSICS)
+
+    const __m512  vq    = _mm512_set1_ps(q);
+    const __m512  vdq   = _mm512_set1_ps(dq);
+    const __m512  vphi  = _mm512_set1_ps(phi);
+    const __m512  vdphi = _mm512_set1_ps(dphi);
+    const __m512  vpi   = _mm512_set1_ps(Config::PI);
+    const __m512  v2pi  = _mm512_set1_ps(Config::TwoPI);
+    const __m512i vstep = _mm512_set1_epi32(16);
+    __m512i       vidx  = _mm512_add_epi32(_mm512_set1_epi32(hi),
+                                           _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+
+    for ( ; hi + 16 <= h2 && n < MkFinder::MPlexHitIdxMax; hi += 16)
+    {
+      const __m512 ddq   = _mm512_abs_ps(_mm512_sub_ps(vq,   _mm512_loadu_ps(hqs   + hi)));
+      __m512       ddphi = _mm512_abs_ps(_mm512_sub_ps(vphi, _mm512_loadu_ps(hphis + hi)));
+      ddphi = _mm512_mask_sub_ps(ddphi, _mm512_cmp_ps_mask(ddphi, vpi, _CMP_GT_OQ), v2pi, ddphi);
+
+      const __mmask16 m = _mm512_cmp_ps_mask(ddq, vdq, _CMP_NGE_UQ) & _mm512_cmp_ps_mask(ddphi, vdphi, _CMP_NGE_UQ);
+
+      _mm512_mask_compressstoreu_epi32(idcs + n, m, vidx);
+      n   += _mm_popcnt_u32(m);
+      vidx = _mm512_add_epi32(vidx, vstep);
+    }
+
+#elif defined(AVX2_INTRINSICS)
+
+    const __m256 vq    = _mm256_set1_ps(q);
+    const __m256 vdq   = _mm256_set1_ps(dq);
+    const __m256 vphi  = _mm256_set1_ps(phi);
+    const __m256 vdphi = _mm256_set1_ps(dphi);
+    const __m256 vpi   = _mm256_set1_ps(Config::PI);
+    const __m256 v2pi  = _mm256_set1_ps(Config::TwoPI);
+    const __m256 vsign = _mm256_set1_ps(-0.0f);
+
+    for ( ; hi + 8 <= h2 && n < MkFinder::MPlexHitIdxMax; hi += 8)
+    {
+      const __m256 ddq   = _mm256_andnot_ps(vsign, _mm256_sub_ps(vq,   _mm256_loadu_ps(hqs   + hi)));
+      __m256       ddphi = _mm256_andnot_ps(vsign, _mm256_sub_ps(vphi, _mm256_loadu_ps(hphis + hi)));
+      ddphi = _mm256_blendv_ps(ddphi, _mm256_sub_ps(v2pi, ddphi), _mm256_cmp_ps(ddphi, vpi, _CMP_GT_OQ));
+
+      const __m256 pass = _mm256_and_ps(_mm256_cmp_ps(ddq,   vdq,   _CMP_NGE_UQ),
+                                        _mm256_cmp_ps(ddphi, vdphi, _CMP_NGE_UQ));
+
+      // No compress-store on AVX2, append passing lanes in order.
+      for (unsigned int m = _mm256_movemask_ps(pass); m != 0; m &= m - 1)
+      {
+        idcs[n++] = hi + __builtin_ctz(m);
+      }
+    }
+
+#endif
+
+    for ( ; hi < h2 && n < MkFinder::MPlexHitIdxMax; ++hi)
+    {
+      const float ddq   =       std::abs(q   - hqs[hi]);
+      if (ddq >= dq) continue;
+      const float ddphi = cdist(std::abs(phi - hphis[hi]));
+      if (ddphi >= dphi) continue;
+
+      idcs[n++] = hi;
+    }
+
+    return n;
+  }
+}
+
 void MkFinder::SelectHitIndices(const LayerOfHits &layer_of_hits,
                                 const int N_proc)
 {
@@ -246,7 +449,7 @@ void MkFinder::SelectHitIndices(const LayerOfHits &layer_of_hits,
       assert(dphi2 >= 0);
 #endif
 
-      const float phi  = getPhi(x, y);
+      const float phi  = Matriplex::fast_atan2(y, x);
       float dphi = calcdphi(dphi2);
 
       const float z  = Par[iI].ConstAt(itrack, 2, 0);
@@ -299,7 +502,7 @@ void MkFinder::SelectHitIndices(const LayerOfHits &layer_of_hits,
       assert(dphi2 >= 0);
 #endif
 
-      const float phi  = getPhi(x, y);
+      const float phi  = Matriplex::fast_atan2(y, x);
       float dphi = calcdphi(dphi2);
 
       const float  r = std::sqrt(r2);
@@ -312,8 +515,8 @@ void MkFinder::SelectHitIndices(const LayerOfHits &layer_of_hits,
         //XXXXMT4GC should we also increase dr?
         //XXXXMT4GC can we just take half of layer dz?
         const float deltaZ = 5;
-        float cosT = std::cos(Par[iI].ConstAt(itrack, 5, 0));
-        float sinT = std::sin(Par[iI].ConstAt(itrack, 5, 0));
+        float cosT, sinT;
+        Matriplex::fast_sincos(Par[iI].ConstAt(itrack, 5, 0), sinT, cosT);
         //here alpha is the helix angular path corresponding to deltaZ
         const float k = Chg.ConstAt(itrack, 0, 0) * 100.f / (-Config::sol*Config::Bfield);
         const float alpha  = deltaZ*sinT*Par[iI].ConstAt(itrack, 3, 0)/(cosT*k);
@@ -324,9 +527,26 @@ void MkFinder::SelectHitIndices(const LayerOfHits &layer_of_hits,
     }
   }
 
-  // Vectorizing this makes it run slower!
-  //#pragma ivdep
-  //#pragma omp simd
+  // Hit collection is done in two passes over tracks. The first one only
+  // prefetches the bin table rows -- the m_phi_bin_infos lookup used to be
+  // the biggest hog because of cache misses. The second one walks the bins.
+  // As hits are sorted by (q bin, phi bin) the hits of consecutive phi bins
+  // in a q row are contiguous and are filtered as one range with SIMD
+  // compares, see select_hits_in_range().
+
+  for (int itrack = 0; itrack < N_proc; ++itrack)
+  {
+    if (XWsrResult[itrack].m_wsr == WSR_Outside) continue;
+
+    for (int qi = qb1v[itrack]; qi < qb2v[itrack]; ++qi)
+    {
+      _mm_prefetch((const char*) &L.phi_bin_info(qi, pb1v[itrack]       & L.m_phi_mask), _MM_HINT_T0);
+      _mm_prefetch((const char*) &L.phi_bin_info(qi, (pb2v[itrack] - 1) & L.m_phi_mask), _MM_HINT_T0);
+    }
+  }
+
+  alignas(64) int idcs[MPlexHitIdxMax + k_select_hits_vec_width];
+
   for (int itrack = 0; itrack < N_proc; ++itrack)
   {
     if (XWsrResult[itrack].m_wsr == WSR_Outside)
@@ -354,58 +574,51 @@ void MkFinder::SelectHitIndices(const LayerOfHits &layer_of_hits,
     // This would then work best with relatively small bin sizes.
     // Or, set them up so I can always take 3x3 array around the intersection.
 
-    for (int qi = qb1; qi < qb2; ++qi)
+    int n = 0;
+
+    for (int qi = qb1; qi < qb2 && n < MPlexHitIdxMax; ++qi)
     {
-      for (int pi = pb1; pi < pb2; ++pi)
+      // Split phi bin range into runs that do not wrap around.
+      for (int pi = pb1; pi < pb2 && n < MPlexHitIdxMax; )
       {
-        const int pb = pi & L.m_phi_mask;
+        const int pb     = pi & L.m_phi_mask;
+        const int pi_end = std::min(pb2, pi + L.m_nphi - pb);
 
-        // MT: The following line is the biggest hog (4% total run time).
-        // This comes from cache misses, I presume.
-        // It might make sense to make first loop to extract bin indices
-        // and issue prefetches at the same time.
-        // Then enter vectorized loop to actually collect the hits in proper order.
+        const int h1 = L.phi_bin_info(qi, pb).first;
+        const int h2 = L.phi_bin_info(qi, (pi_end - 1) & L.m_phi_mask).second;
 
-        //SK: ~20x1024 bin sizes give mostly 1 hit per bin. Commented out for 128 bins or less
-        // #pragma nounroll
-        for (uint16_t hi = L.m_phi_bin_infos[qi][pb].first; hi < L.m_phi_bin_infos[qi][pb].second; ++hi)
+        if (Config::usePhiQArrays)
+        {
+          n = select_hits_in_range(L.m_hit_qs.data(), L.m_hit_phis.data(), h1, h2,
+                                   q, dq, phi, dphi, idcs, n);
+        }
+        else
         {
-          // MT: Access into m_hit_zs and m_hit_phis is 1% run-time each.
+          // MT: The following check alone makes more sense with spiral traversal,
+          // we'd be taking in closest hits first.
+          for (int hi = h1; hi < h2 && n < MPlexHitIdxMax; ++hi)
+          {
+            idcs[n++] = hi;
+          }
+        }
 
-	  if (Config::usePhiQArrays)
-	  {
-            if (XHitSize[itrack] >= MPlexHitIdxMax) break;
-
-            const float ddq   =       std::abs(q   - L.m_hit_qs[hi]);
-            if (ddq >= dq) continue;
-            const float ddphi = cdist(std::abs(phi - L.m_hit_phis[hi]));
-            if (ddphi >= dphi) continue;
-            
-            // dprintf("     SHI %3d %4d %4d %5d  %6.3f %6.3f %6.4f %7.5f   %s\n",
-            //         qi, pi, pb, hi,
-            //         L.m_hit_qs[hi], L.m_hit_phis[hi], ddq, ddphi,
-            //         (ddq < dq && ddphi < dphi) ? "PASS" : "FAIL");
-            
-            // MT: Removing extra check gives full efficiency ...
-            //     and means our error estimations are wrong!
-            // Avi says we should have *minimal* search windows per layer.
-            // Also ... if bins are sufficiently small, we do not need the extra
-            // checks, see above.
-	    XHitArr.At(itrack, XHitSize[itrack]++, 0) = hi;
-	  }
-	  else
-	  {
-	    // MT: The following check alone makes more sense with spiral traversal,
-	    // we'd be taking in closest hits first.
-	    if (XHitSize[itrack] < MPlexHitIdxMax)
-	    {
-	      XHitArr.At(itrack, XHitSize[itrack]++, 0) = hi;
-	    }
-	  }
-        }//for (uint16_t hi =
-      }//pi
-    }//qi
-  }//itrack
+        pi = pi_end;
+      }
+    }
+
+    // MT: Removing extra check gives full efficiency ...
+    //     and means our error estimations are wrong!
+    // Avi says we should have *minimal* search windows per layer.
+    // Also ... if bins are sufficiently small, we do not need the extra
+    // checks, see above.
+
+    n = std::min(n, MPlexHitIdxMax);
+    for (int i = 0; i < n; ++i)
+    {
+      XHitArr.At(itrack, i, 0) = idcs[i];
+    }
+    XHitSize[itrack] = n;
+  }
 }
 
 
@@ -416,12 +629,18 @@ void MkFinder::SelectHitIndices(const LayerOfHits &layer_of_hits,
 //#define NO_PREFETCH
 //#define NO_GATHER
 
+// With SoA hits each component is gathered separately, prefetching whole
+// Hit objects would only add memory traffic.
+#if defined(HIT_SOA) && ! defined(NO_PREFETCH)
+#define NO_PREFETCH
+#endif
+
 void MkFinder::AddBestHit(const LayerOfHits &layer_of_hits, const int N_proc,
                           const FindingFoos &fnd_foos)
 {
   // debug = true;
 
-  MatriplexHitPacker mhp(layer_of_hits.m_hits[0]);
+  MatriplexLayerHitPacker mhp(layer_of_hits);
 
   float minChi2[NN];
   int   bestHit[NN];
@@ -430,7 +649,9 @@ void MkFinder::AddBestHit(const LayerOfHits &layer_of_hits, const int N_proc,
   // std::fill_n(minChi2, NN, Config::chi2Cut);
   // std::fill_n(bestHit, NN, -1);
 
+#ifndef NO_PREFETCH
   const char *varr      = (char*) layer_of_hits.m_hits;
+#endif
 
   int maxSize = 0;
 
@@ -508,7 +729,7 @@ void MkFinder::AddBestHit(const LayerOfHits &layer_of_hits, const int N_proc,
     //now compute the chi2 of track state vs hit
     MPlexQF outChi2;
     (*fnd_foos.m_compute_chi2_foo)(Err[iP], Par[iP], Chg, msErr, msPar,
-                                   outChi2, N_proc, Config::finding_intra_layer_pflags);
+                                   outChi2, N_proc);
 
 #ifndef NO_PREFETCH
     // Prefetch to L1 the hits we'll process in the next loop iteration.
@@ -610,7 +831,7 @@ void MkFinder::AddBestHit(const LayerOfHits &layer_of_hits, const int N_proc,
 
   dprint("update parameters");
   (*fnd_foos.m_update_param_foo)(Err[iP], Par[iP], Chg, msErr, msPar,
-                                 Err[iC], Par[iC], N_proc, Config::finding_intra_layer_pflags);
+                                 Err[iC], Par[iC], N_proc);
 
   //std::cout << "Par[iP](0,0,0)=" << Par[iP](0,0,0) << " Par[iC](0,0,0)=" << Par[iC](0,0,0)<< std::endl;
 }
@@ -620,15 +841,17 @@ void MkFinder::AddBestHit(const LayerOfHits &layer_of_hits, const int N_proc,
 //==============================================================================
 
 void MkFinder::FindCandidates(const LayerOfHits &layer_of_hits,
-                              std::vector<std::vector<Track>>& tmp_candidates,
+                              std::vector<std::vector<TrackCand>>& tmp_candidates,
                               const int offset, const int N_proc,
                               const FindingFoos &fnd_foos)
 {
   // bool debug = true;
 
-  MatriplexHitPacker mhp(layer_of_hits.m_hits[0]);
+  MatriplexLayerHitPacker mhp(layer_of_hits);
 
+#ifndef NO_PREFETCH
   const char *varr = (char*) layer_of_hits.m_hits;
+#endif
 
   int maxSize = 0;
 
@@ -640,11 +863,13 @@ void MkFinder::FindCandidates(const LayerOfHits &layer_of_hits,
     {
       if (XHitSize[it] > 0)
       {
+#ifndef NO_PREFETCH
 	_mm_prefetch(varr + XHitArr.At(it, 0, 0) * sizeof(Hit), _MM_HINT_T0);
 	if (XHitSize[it] > 1)
 	{
 	  _mm_prefetch(varr + XHitArr.At(it, 1, 0) * sizeof(Hit), _MM_HINT_T1);
 	}
+#endif
 	maxSize = std::max(maxSize, XHitSize[it]);
       }
     }
@@ -667,6 +892,7 @@ void MkFinder::FindCandidates(const LayerOfHits &layer_of_hits,
       }
     }
 
+#ifndef NO_PREFETCH
     // Prefetch to L2 the hits we'll (probably) process after two loops iterations.
     // Ideally this would be initiated before coming here, for whole bunch_of_hits.m_hits vector.
     for (int itrack = 0; itrack < N_proc; ++itrack)
@@ -676,14 +902,16 @@ void MkFinder::FindCandidates(const LayerOfHits &layer_of_hits,
 	_mm_prefetch(varr + XHitArr.At(itrack, hit_cnt+2, 0)*sizeof(Hit), _MM_HINT_T1);
       }
     }
+#endif
 
     mhp.Pack(msErr, msPar);
 
     //now compute the chi2 of track state vs hit
     MPlexQF outChi2;
     (*fnd_foos.m_compute_chi2_foo)(Err[iP], Par[iP], Chg, msErr, msPar,
-                                   outChi2, N_proc, Config::finding_intra_layer_pflags);
+                                   outChi2, N_proc);
 
+#ifndef NO_PREFETCH
     // Prefetch to L1 the hits we'll (probably) process in the next loop iteration.
     for (int itrack = 0; itrack < N_proc; ++itrack)
     {
@@ -692,6 +920,7 @@ void MkFinder::FindCandidates(const LayerOfHits &layer_of_hits,
 	_mm_prefetch(varr + XHitArr.At(itrack, hit_cnt+1, 0)*sizeof(Hit), _MM_HINT_T0);
       }
     }
+#endif
 
     //now update the track parameters with this hit (note that some calculations are already done when computing chi2, to be optimized)
     //this is not needed for candidates the hit is not added to, but it's vectorized so doing it serially below should take the same time
@@ -714,7 +943,7 @@ void MkFinder::FindCandidates(const LayerOfHits &layer_of_hits,
     if (oneCandPassCut)
     {
       (*fnd_foos.m_update_param_foo)(Err[iP], Par[iP], Chg, msErr, msPar,
-                                     Err[iC], Par[iC], N_proc, Config::finding_intra_layer_pflags);
+                                     Err[iC], Par[iC], N_proc);
 
       dprint("update parameters" << std::endl
 	     << "propagated track parameters x=" << Par[iP].ConstAt(0, 0, 0) << " y=" << Par[iP].ConstAt(0, 1, 0) << std::endl
@@ -733,7 +962,7 @@ void MkFinder::FindCandidates(const LayerOfHits &layer_of_hits,
 	  {
 	    dprint("chi2 cut passed, creating new candidate");
 	    //create a new candidate and fill the reccands_tmp vector
-	    Track newcand;
+	    TrackCand newcand;
             copy_out(newcand, itrack, iC);
 	    newcand.addHitIdx(XHitArr.At(itrack, hit_cnt, 0), layer_of_hits.layer_id(), chi2);
 	    newcand.setSeedTypeForRanking(SeedType(itrack, 0, 0));
@@ -765,7 +994,7 @@ void MkFinder::FindCandidates(const LayerOfHits &layer_of_hits,
       continue;
     }
 
-    int fake_hit_idx = num_invalid_hits(itrack,true) < Config::maxHolesPerCand ? -1 : -2;
+    int fake_hit_idx = num_all_minus_one_hits(itrack) < Config::maxHolesPerCand ? -1 : -2;
 
     if (XWsrResult[itrack].m_wsr == WSR_Edge)
     {
@@ -775,7 +1004,7 @@ void MkFinder::FindCandidates(const LayerOfHits &layer_of_hits,
 
     dprint("ADD FAKE HIT FOR TRACK #" << itrack << " withinBounds=" << (fake_hit_idx != -3) << " r=" << std::hypot(Par[iP](itrack,0,0), Par[iP](itrack,1,0)));
 
-    Track newcand;
+    TrackCand newcand;
     copy_out(newcand, itrack, iP);
     newcand.addHitIdx(fake_hit_idx, layer_of_hits.layer_id(), 0.);
     newcand.setSeedTypeForRanking(SeedType(itrack, 0, 0));
@@ -795,9 +1024,14 @@ void MkFinder::FindCandidatesCloneEngine(const LayerOfHits &layer_of_hits, CandC
 {
   // bool debug = true;
 
-  MatriplexHitPacker mhp(layer_of_hits.m_hits[0]);
+  MatriplexLayerHitPacker mhp(layer_of_hits);
 
+#ifndef NO_PREFETCH
   const char *varr      = (char*) layer_of_hits.m_hits;
+#endif
+
+  MPlexQI candHitIdx, candScore, candAccept;
+  MPlexQF candChi2;
 
   int maxSize = 0;
 
@@ -810,11 +1044,13 @@ void MkFinder::FindCandidatesCloneEngine(const LayerOfHits &layer_of_hits, CandC
     {
       if (XHitSize[it] > 0)
       {
+#ifndef NO_PREFETCH
         _mm_prefetch(varr + XHitArr.At(it, 0, 0) * sizeof(Hit), _MM_HINT_T0);
         if (XHitSize[it] > 1)
         {
           _mm_prefetch(varr + XHitArr.At(it, 1, 0) * sizeof(Hit), _MM_HINT_T1);
         }
+#endif
         maxSize = std::max(maxSize, XHitSize[it]);
       }
     }
@@ -838,6 +1074,7 @@ void MkFinder::FindCandidatesCloneEngine(const LayerOfHits &layer_of_hits, CandC
       }
     }
 
+#ifndef NO_PREFETCH
     // Prefetch to L2 the hits we'll (probably) process after two loops iterations.
     // Ideally this would be initiated before coming here, for whole bunch_of_hits.m_hits vector.
     for (int itrack = 0; itrack < N_proc; ++itrack)
@@ -847,13 +1084,15 @@ void MkFinder::FindCandidatesCloneEngine(const LayerOfHits &layer_of_hits, CandC
         _mm_prefetch(varr + XHitArr.At(itrack, hit_cnt+2, 0)*sizeof(Hit), _MM_HINT_T1);
       }
     }
+#endif
 
     mhp.Pack(msErr, msPar);
 
     //now compute the chi2 of track state vs hit
     MPlexQF outChi2;
-    (*fnd_foos.m_compute_chi2_foo)(Err[iP], Par[iP], Chg, msErr, msPar, outChi2, N_proc, Config::finding_intra_layer_pflags);
+    (*fnd_foos.m_compute_chi2_foo)(Err[iP], Par[iP], Chg, msErr, msPar, outChi2, N_proc);
 
+#ifndef NO_PREFETCH
     // Prefetch to L1 the hits we'll (probably) process in the next loop iteration.
     for (int itrack = 0; itrack < N_proc; ++itrack)
     {
@@ -862,67 +1101,49 @@ void MkFinder::FindCandidatesCloneEngine(const LayerOfHits &layer_of_hits, CandC
         _mm_prefetch(varr + XHitArr.At(itrack, hit_cnt+1, 0)*sizeof(Hit), _MM_HINT_T0);
       }
     }
+#endif
 
-#pragma omp simd // DOES NOT VECTORIZE AS IT IS NOW
+    // Score all lanes, the chi2 cut and window size give the accept mask.
+    // Survivors are compress-stored into the cloner's new-hit buffer.
+#pragma omp simd
     for (int itrack = 0; itrack < N_proc; ++itrack)
     {
       // make sure the hit was in the compatiblity window for the candidate
-
-      if (hit_cnt < XHitSize[itrack])
-      {
-        const float chi2 = fabs(outChi2[itrack]);//fixme negative chi2 sometimes...
-        dprint("chi2=" << chi2 << " for trkIdx=" << itrack << " hitIdx=" << XHitArr.At(itrack, hit_cnt, 0));
-        if (chi2 < Config::chi2Cut)
-        {
-          IdxChi2List tmpList;
-          tmpList.trkIdx = CandIdx(itrack, 0, 0);
-          tmpList.hitIdx = XHitArr.At(itrack, hit_cnt, 0);
-          tmpList.nhits  = NFoundHits(itrack,0,0) + 1;
-          tmpList.nholes  = num_invalid_hits(itrack,true);
-          tmpList.seedtype = SeedType(itrack, 0, 0);
-          tmpList.pt = std::abs(1.0f/Par[iP].At(itrack,3,0));
-          tmpList.chi2   = Chi2(itrack, 0, 0) + chi2;
-          tmpList.score  = getScoreStruct(tmpList);
-          cloner.add_cand(SeedIdx(itrack, 0, 0) - offset, tmpList);
-          // hitsToAdd[SeedIdx(itrack, 0, 0)-offset].push_back(tmpList);
-          dprint("  adding hit with hit_cnt=" << hit_cnt << " for trkIdx=" << tmpList.trkIdx << " orig Seed=" << Label(itrack, 0, 0));
-        }
-      }
+      const float chi2 = fabs(outChi2[itrack]);//fixme negative chi2 sometimes...
+
+      candAccept[itrack] = hit_cnt < XHitSize[itrack] && chi2 < Config::chi2Cut;
+      candHitIdx[itrack] = XHitArr.At(itrack, hit_cnt, 0);
+      candChi2  [itrack] = Chi2(itrack, 0, 0) + chi2;
+      candScore [itrack] = getScoreCalc(SeedType(itrack, 0, 0), NFoundHits(itrack, 0, 0) + 1,
+                                        num_all_minus_one_hits(itrack),
+                                        clampChi2ForRanking(candChi2[itrack]),
+                                        std::abs(1.0f/Par[iP].At(itrack,3,0)));
     }
+    cloner.add_cands(SeedIdx, offset, CandIdx, candHitIdx, candChi2, candScore, candAccept, N_proc);
 
   }//end loop over hits
 
   //now add invalid hit
+  // Tracks that missed the layer (WSR_Outside) are handled outside, they keep previous parameters.
+#pragma omp simd
   for (int itrack = 0; itrack < N_proc; ++itrack)
   {
-    dprint("num_invalid_hits(" << itrack << ")=" << num_invalid_hits(itrack,true));
-
-    if (XWsrResult[itrack].m_wsr == WSR_Outside)
-    {
-      // fake_hit_idx = -4;
-      dprint("track missed layer, not adding a clone with a missing hit");
-      continue; // handled outside, keep previous parameters
-    }
-
-    int fake_hit_idx = num_invalid_hits(itrack,true) < Config::maxHolesPerCand ? -1 : -2;
+    int fake_hit_idx = num_all_minus_one_hits(itrack) < Config::maxHolesPerCand ? -1 : -2;
 
     if (XWsrResult[itrack].m_wsr == WSR_Edge)
     {
       fake_hit_idx = -3;
     }
 
-    IdxChi2List tmpList;
-    tmpList.trkIdx = CandIdx(itrack, 0, 0);
-    tmpList.hitIdx = fake_hit_idx;
-    tmpList.nhits  = NFoundHits(itrack,0,0);
-    tmpList.nholes  = num_invalid_hits(itrack,false);
-    tmpList.seedtype = SeedType(itrack, 0, 0);
-    tmpList.pt = std::abs(1.0f/Par[iP].At(itrack,3,0));
-    tmpList.chi2   = Chi2(itrack, 0, 0);
-    tmpList.score  = getScoreStruct(tmpList);
-    cloner.add_cand(SeedIdx(itrack, 0, 0) - offset, tmpList);
-    dprint("adding invalid hit " << fake_hit_idx);
+    candAccept[itrack] = XWsrResult[itrack].m_wsr != WSR_Outside;
+    candHitIdx[itrack] = fake_hit_idx;
+    candChi2  [itrack] = Chi2(itrack, 0, 0);
+    candScore [itrack] = getScoreCalc(SeedType(itrack, 0, 0), NFoundHits(itrack, 0, 0),
+                                      num_inside_minus_one_hits(itrack),
+                                      clampChi2ForRanking(candChi2[itrack]),
+                                      std::abs(1.0f/Par[iP].At(itrack,3,0)));
   }
+  cloner.add_cands(SeedIdx, offset, CandIdx, candHitIdx, candChi2, candScore, candAccept, N_proc);
 }
 
 
@@ -935,7 +1156,7 @@ void MkFinder::UpdateWithLastHit(const LayerOfHits &layer_of_hits, int N_proc,
 {
   for (int i = 0; i < N_proc; ++i)
   {
-    const HitOnTrack &hot = HoTArrs[i][ NHits[i] - 1];
+    const HitOnTrack &hot = LastHoT[i];
 
     if (hot.index < 0) continue;
 
@@ -946,7 +1167,7 @@ void MkFinder::UpdateWithLastHit(const LayerOfHits &layer_of_hits, int N_proc,
   }
 
   (*fnd_foos.m_update_param_foo)(Err[iP], Par[iP], Chg, msErr, msPar,
-                                 Err[iC], Par[iC], N_proc, Config::finding_intra_layer_pflags);
+                                 Err[iC], Par[iC], N_proc);
 
   //now that we have moved propagation at the end of the sequence we lost the handle of
   //using the propagated parameters instead of the updated for the missing hit case.
@@ -955,10 +1176,10 @@ void MkFinder::UpdateWithLastHit(const LayerOfHits &layer_of_hits, int N_proc,
 
   for (int i = 0; i < N_proc; ++i)
   {
-    if (HoTArrs[i][ NHits[i] - 1].index < 0)
+    if (LastHoT[i].index < 0)
     {
       printf("MkFinder::UpdateWithLastHit hit with negative index %d ... i=%d, N_proc=%d.\n",
-             HoTArrs[i][ NHits[i] - 1].index, i, N_proc);
+             LastHoT[i].index, i, N_proc);
       assert (false && "This should not happen now that CandCloner builds a true update list.");
       /*
       float tmp[21];
@@ -989,10 +1210,7 @@ void MkFinder::CopyOutParErr(std::vector<CombCandidate>& seed_cand_vec,
   for (int i = 0; i < N_proc; ++i)
   {
     //create a new candidate and fill the cands_for_next_lay vector
-    Track &cand = seed_cand_vec[SeedIdx(i, 0, 0)][CandIdx(i, 0, 0)];
-
-    // clone-engine update can remove the last hit if invalid (no chi2 change)
-    cand.setNTotalHits(NHits[i]);
+    TrackCand &cand = seed_cand_vec[SeedIdx(i, 0, 0)][CandIdx(i, 0, 0)];
 
     //set the track state to the updated parameters
     Err[iO].CopyOut(i, cand.errors_nc().Array());
@@ -1031,6 +1249,12 @@ void MkFinder::BkFitInputTracks(TrackVec& cands, int beg, int end)
     mtp.AddInput(trk);
   }
 
+  const int next_end = std::min(end + NN, (int) cands.size());
+  for (int i = end; i < next_end; ++i)
+  {
+    MatriplexTrackPacker::Prefetch(cands[i]);
+  }
+
   Chi2.SetVal(0);
 
   mtp.Pack(Err[iC], Par[iC]);
@@ -1042,22 +1266,24 @@ void MkFinder::BkFitInputTracks(TrackVec& cands, int beg, int end)
 
 void MkFinder::BkFitInputTracks(EventOfCombCandidates& eocss, int beg, int end)
 {
-  // XXXX Can cause trouble if per-seed vectors get scattered beyond 2GB (or maybe 8).
-
   // SlurpIn based on XHit array - so Nhits is irrelevant.
   // Could as well use HotArrays from tracks directly + a local cursor array to last hit.
 
-  MatriplexTrackPacker mtp(eocss[beg][0]);
+  MatriplexTrackCandPacker mtp(eocss[beg][0]);
 
   int itrack = 0;
 
   for (int i = beg; i < end; ++i, ++itrack)
   {
-    const Track &trk = eocss[i][0];
+    const TrackCand &trk = eocss[i][0];
+
+    // Flatten hits from the node chain into HoTArrs.
+    const Track flat = trk.exportTrack();
+    std::copy(flat.BeginHitsOnTrack(), flat.EndHitsOnTrack(), HoTArrs[itrack]);
 
     Chg(itrack, 0, 0) = trk.charge();
-    CurHit[itrack]    = trk.nTotalHits() - 1;
-    HoTArr[itrack]    = trk.getHitsOnTrackArray();
+    CurHit[itrack]    = flat.nTotalHits() - 1;
+    HoTArr[itrack]    = HoTArrs[itrack];
 
     mtp.AddInput(trk);
   }
@@ -1097,7 +1323,7 @@ void MkFinder::BkFitOutputTracks(EventOfCombCandidates& eocss, int beg, int end)
   int itrack = 0;
   for (int i = beg; i < end; ++i, ++itrack)
   {
-    Track &trk = eocss[i][0];
+    TrackCand &trk = eocss[i][0];
 
     Err[iP].CopyOut(itrack, trk.errors_nc().Array());
     Par[iP].CopyOut(itrack, trk.parameters_nc().Array());
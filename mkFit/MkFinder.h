@@ -13,7 +13,9 @@ namespace mkfit {
 
 class CandCloner;
 class CombCandidate;
-class LayerOfHits;
+class TrackCand;
+template <typename IdxT> class LayerOfHitsT;
+typedef LayerOfHitsT<hit_idx_t> LayerOfHits;
 class FindingFoos;
 
 // For backward fit hack
@@ -63,6 +65,14 @@ public:
   MPlexQI    NFoundHits;
   HitOnTrack HoTArrs[NN][Config::nMaxTrkHits];
 
+  // Combinatorial candidates keep hits in CombCandidate::m_hots, only the
+  // index of the last node and hole counters are carried through here.
+  MPlexQI        NInsideMinusOneHits;
+  MPlexQI        NTailMinusOneHits;
+  MPlexQI        LastHitCcIndex;
+  HitOnTrack     LastHoT[NN];
+  CombCandidate *CombCand[NN];
+
   MPlexQUI   SeedType; // seed range for ranking (0 = not set; 1 = high pT central seeds; 2 = low pT endcap seeds; 3 = all other seeds)
   MPlexQI    SeedIdx; // seed index in local thread (for bookkeeping at thread level)
   MPlexQI    CandIdx; // candidate index for the given seed (for bookkeeping of clone engine)
@@ -104,6 +114,14 @@ public:
                             const std::vector<std::pair<int,IdxChi2List>>& idxs,
                             int beg, int end, bool inputProp);
 
+  // Input for UpdateWithLastHit(). Propagated state is taken from per-batch
+  // Matriplexes at positions src_pos (kept by CandCloner), the rest from tracks.
+  void InputTracksForUpdate(const std::vector<CombCandidate>& tracks,
+                            const std::vector<std::pair<int,int>>& idxs,
+                            const std::vector<int>& src_pos,
+                            const MPlexLS *prop_err, const MPlexLV *prop_par,
+                            int beg, int end);
+
   void OutputTracksAndHitIdx(std::vector<Track>& tracks,
                              int beg, int end, bool outputProp) const;
 
@@ -123,7 +141,7 @@ public:
   //----------------------------------------------------------------------------
 
   void FindCandidates(const LayerOfHits &layer_of_hits,
-                      std::vector<std::vector<Track>>& tmp_candidates,
+                      std::vector<std::vector<TrackCand>>& tmp_candidates,
 		      const int offset, const int N_proc,
                       const FindingFoos &fnd_foos);
 
@@ -164,6 +182,12 @@ private:
     Err[tslot].CopyIn(mslot, trk.errors().Array());
     Par[tslot].CopyIn(mslot, trk.parameters().Array());
 
+    copy_in_no_state(trk, mslot);
+  }
+
+  // All but errors and parameters, those are gathered with track packers.
+  void copy_in_no_state(const Track& trk, const int mslot)
+  {
     Chg  (mslot, 0, 0) = trk.charge();
     Chi2 (mslot, 0, 0) = trk.chi2();
     Label(mslot, 0, 0) = trk.label();
@@ -187,6 +211,10 @@ private:
     std::copy(HoTArrs[mslot], & HoTArrs[mslot][NHits(mslot, 0, 0)], trk.BeginHitsOnTrack_nc());
   }
 
+  void copy_in (const TrackCand& trk, const int mslot, const int tslot);
+  void copy_in_no_state(const TrackCand& trk, const int mslot);
+  void copy_out(TrackCand& trk, const int mslot, const int tslot) const;
+
   void add_hit(const int mslot, int index, int layer)
   {
     int &n_tot_hits = NHits(mslot, 0, 0);
@@ -218,15 +246,14 @@ private:
     }
   }
 
-  int num_invalid_hits(const int mslot, bool insideValid = false) const
+  int num_all_minus_one_hits(const int mslot) const
   {
-    int n = 0;
-    for (int i = NHits(mslot, 0, 0)-1; i >= 0; --i)
-      {
-	if (HoTArrs[mslot][i].index >= 0) insideValid = true;
-	if (insideValid && HoTArrs[mslot][i].index == -1) ++n;
-      }
-    return n;
+    return NInsideMinusOneHits(mslot, 0, 0) + NTailMinusOneHits(mslot, 0, 0);
+  }
+
+  int num_inside_minus_one_hits(const int mslot) const
+  {
+    return NInsideMinusOneHits(mslot, 0, 0);
   }
 };
 
@@ -36,14 +36,12 @@ void MkFinderFV<nseeds, ncands>::InputTrack(const Track& track, int iseed, int o
 }
 
 template<int nseeds, int ncands>
-void MkFinderFV<nseeds, ncands>::OutputTrack(std::vector<Track>& tracks,
-                           int itrack, int imp, bool outputProp) const
+void MkFinderFV<nseeds, ncands>::OutputTrack(Track& track, int imp, bool outputProp) const
 {
   // Copies requested track parameters into Track object.
-  // The tracks vector should be resized to allow direct copying.
 
   const int iO = outputProp ? iP : iC;
-  copy_out(tracks[itrack], imp, iO);
+  copy_out(track, imp, iO);
 }
 
 //==============================================================================
@@ -115,7 +113,7 @@ void MkFinderFV<nseeds, ncands>::SelectHitIndices(const LayerOfHits &layer_of_hi
       assert(dphi2 >= 0);
   #endif
 
-      const float phi  = getPhi(x, y);
+      const float phi  = Matriplex::fast_atan2(y, x);
       float dphi = calcdphi(dphi2);
 
       const float z  = Par[iI].ConstAt(itrack, 2, 0);
@@ -161,7 +159,7 @@ void MkFinderFV<nseeds, ncands>::SelectHitIndices(const LayerOfHits &layer_of_hi
       assert(dphi2 >= 0);
   #endif
 
-      const float phi  = getPhi(x, y);
+      const float phi  = Matriplex::fast_atan2(y, x);
       float dphi = calcdphi(dphi2);
 
       const float  r = std::sqrt(r2);
@@ -173,8 +171,8 @@ void MkFinderFV<nseeds, ncands>::SelectHitIndices(const LayerOfHits &layer_of_hi
         //fixme! using constant value, to be taken from layer properties
         //XXXXMT4GC should we also increase dr?
         const float deltaZ = 5;
-        const float cosT = std::cos(Par[iI].ConstAt(itrack, 5, 0));
-        const float sinT = std::sin(Par[iI].ConstAt(itrack, 5, 0));
+        float cosT, sinT;
+        Matriplex::fast_sincos(Par[iI].ConstAt(itrack, 5, 0), sinT, cosT);
         //here alpha is the helix angular path corresponding to deltaZ
         const float k = Chg.ConstAt(itrack, 0, 0) * 100.f / (-Config::sol*Config::Bfield);
         const float alpha  = deltaZ*sinT*Par[iI].ConstAt(itrack, 3, 0)/(cosT*k);
@@ -218,17 +216,17 @@ void MkFinderFV<nseeds, ncands>::SelectHitIndices(const LayerOfHits &layer_of_hi
       << pb1[iseed] << "-" << pb2[iseed]);
   }
 
-  _mm_prefetch((const char*) &L.m_phi_bin_infos[qb1[0]][pb1[0] & L.m_phi_mask], _MM_HINT_T0);
+  _mm_prefetch((const char*) &L.phi_bin_info(qb1[0], pb1[0] & L.m_phi_mask), _MM_HINT_T0);
 
   for (auto iseed = 0; iseed < nseeds; ++iseed) {
     const int base = iseed*ncands;
     for (int qi = qb1[iseed]; qi < qb2[iseed]; ++qi) {
       if (qi+1 < qb2[iseed]) {
-        _mm_prefetch((const char*) &L.m_phi_bin_infos[qi+1][pb1[iseed] & L.m_phi_mask], _MM_HINT_T0);
+        _mm_prefetch((const char*) &L.phi_bin_info(qi+1, pb1[iseed] & L.m_phi_mask), _MM_HINT_T0);
       }
       for (int pi = pb1[iseed]; pi < pb2[iseed]; ++pi) {
         int pb = pi & L.m_phi_mask;
-        for (int hi = L.m_phi_bin_infos[qi][pb].first; hi < L.m_phi_bin_infos[qi][pb].second; ++hi) {
+        for (hit_idx_t hi = L.phi_bin_info(qi, pb).first; hi < L.phi_bin_info(qi, pb).second; ++hi) {
           unsigned int pass[ncands] = {};
           if (Config::usePhiQArrays) {
             #pragma omp simd
@@ -326,7 +324,7 @@ void MkFinderFV<nseeds, ncands>::FindCandidates(const LayerOfHits &layer_of_hits
     mhp.Pack(msErr, msPar);
 
     //now compute the chi2 of track state vs hit
-    (*fnd_foos.m_compute_chi2_foo)(Err[iP], Par[iP], Chg, msErr, msPar, XHitChi2[hit_cnt], NNFV, Config::finding_intra_layer_pflags);
+    (*fnd_foos.m_compute_chi2_foo)(Err[iP], Par[iP], Chg, msErr, msPar, XHitChi2[hit_cnt], NNFV);
 
     // Prefetch to L1 the hits we'll (probably) process in the next loop iteration.
     for (int itrack = 0; itrack < NNFV; ++itrack)
@@ -365,7 +363,7 @@ void MkFinderFV<nseeds, ncands>::UpdateWithLastHit(const LayerOfHits &layer_of_h
   }
 
   (*fnd_foos.m_update_param_foo)(Err[iP], Par[iP], Chg, msErr, msPar,
-                                 Err[iC], Par[iC], NNFV, Config::finding_intra_layer_pflags);
+                                 Err[iC], Par[iC], NNFV);
 
   //now that we have moved propagation at the end of the sequence we lost the handle of
   //using the propagated parameters instead of the updated for the missing hit case.
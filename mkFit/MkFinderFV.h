@@ -14,7 +14,8 @@ namespace mkfit {
 
 class CandCloner;
 class CombCandidate;
-class LayerOfHits;
+template <typename IdxT> class LayerOfHitsT;
+typedef LayerOfHitsT<hit_idx_t> LayerOfHits;
 class FindingFoos;
 
 // NOTES from MkFitter ... where things were getting super messy.
@@ -110,7 +111,7 @@ public:
   //----------------------------------------------------------------------------
 
   void InputTrack(const Track& track, int iseed, int offset, bool inputProp);
-  void OutputTrack(std::vector<Track>& tracks, int itrack, int imp, bool outputProp) const;
+  void OutputTrack(Track& track, int imp, bool outputProp) const;
 
   //----------------------------------------------------------------------------
 
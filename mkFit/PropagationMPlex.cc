@@ -1,5 +1,7 @@
 #include "MaterialEffects.h"
 #include "PropagationMPlex.h"
+#include "Matriplex/MatriplexFastMath.h"
+#include "TrackerInfo.h"
 
 //#define DEBUG
 #include "Debug.h"
@@ -401,23 +403,150 @@ void helixAtRFromIterativeCCS(const MPlexLV& inPar,     const MPlexQI& inChg, co
 }
 
 
+template<typename TPF>
+static void helixAtRFromIntersection_impl(const MPlexLV& inPar,     const MPlexQI& inChg, const MPlexQF &msRad,
+                                                MPlexLV& outPar,          MPlexLL& errorProp,
+                                          const int      N_proc,    const TPF      pflags)
+{
+  // Newton iteration on the turning angle alpha: a step is the radial distance to go
+  // divided by dr/dalpha = rho * (r.p)/(|r||p|), rho being the signed radius of the helix.
+  // Converged lanes are frozen and the loop ends once all of them are within
+  // Config::helixAtRTolerance, usually after one or two steps between barrel layers.
+  // Derivatives of alpha follow from the cylinder condition x(alpha)^2 + y(alpha)^2 = r^2.
+  // Expects outPar = inPar on entry, as helixAtRFromIterativeCCS() does.
+
+  MPlexQF rho, cpsi, spsi, r0, alpha;
+
+#pragma omp simd
+  for (int n = 0; n < NN; ++n)
+  {
+    const float x   = inPar(n, 0, 0);
+    const float y   = inPar(n, 1, 0);
+    r0(n, 0, 0)     = hipo(x, y);
+    const float k   = inChg(n, 0, 0) * 100.f / (-Config::sol*(pflags.use_param_b_field ? Config::BfieldFromZR(inPar(n,2,0),r0(n, 0, 0)) : Config::Bfield));
+    rho(n, 0, 0)    = k / inPar(n, 3, 0);
+    cpsi(n, 0, 0)   = std::cos(inPar(n, 4, 0));
+    spsi(n, 0, 0)   = std::sin(inPar(n, 4, 0));
+    alpha(n, 0, 0)  = 0.f;
+  }
+
+  int n_active = N_proc;
+  for (int i = 0; i < Config::Niter && n_active > 0; ++i)
+  {
+    n_active = 0;
+#pragma omp simd reduction(+:n_active)
+    for (int n = 0; n < NN; ++n)
+    {
+      const float r   = msRad(n, 0, 0);
+      const float x   = outPar(n, 0, 0);
+      const float y   = outPar(n, 1, 0);
+      const float dr  = r - r0(n, 0, 0);
+      const float dot = x*cpsi(n, 0, 0) + y*spsi(n, 0, 0);
+
+      const bool  active = n < N_proc && std::abs(dr) >= Config::helixAtRTolerance;
+      // Far from radial motion (near the apex of a looper, or at the origin) fall back
+      // to the plain r - r0 step of the iterative version.
+      const float slope  = dot > 0.1f*r0(n, 0, 0) ? r0(n, 0, 0)/dot : 1.f;
+      const float da     = active ? dr*slope/rho(n, 0, 0) : 0.f;
+
+      float sina, cosa;
+      if (Config::useTrigApprox) {
+        sincos4(da, sina, cosa);
+      } else {
+        cosa=std::cos(da);
+        sina=std::sin(da);
+      }
+
+      const float c = cpsi(n, 0, 0);
+      const float s = spsi(n, 0, 0);
+      outPar(n, 0, 0) = x + rho(n, 0, 0)*(c*sina - s*(1.f-cosa));
+      outPar(n, 1, 0) = y + rho(n, 0, 0)*(s*sina + c*(1.f-cosa));
+      cpsi(n, 0, 0)   = c*cosa - s*sina;
+      spsi(n, 0, 0)   = s*cosa + c*sina;
+      alpha(n, 0, 0) += da;
+      r0(n, 0, 0)     = hipo(outPar(n, 0, 0), outPar(n, 1, 0));
+
+      dprint_np(n, "newton step " << i << " r=" << r << " r0=" << r0(n, 0, 0) << " da=" << da);
+
+      n_active += (n < N_proc && std::abs(r - r0(n, 0, 0)) >= Config::helixAtRTolerance) ? 1 : 0;
+    }
+  }
+
+#pragma omp simd
+  for (int n = 0; n < NN; ++n)
+  {
+    const float xin  = inPar(n, 0, 0);
+    const float yin  = inPar(n, 1, 0);
+    const float ipt  = inPar(n, 3, 0);
+    const float x    = outPar(n, 0, 0);
+    const float y    = outPar(n, 1, 0);
+    const float k    = rho(n, 0, 0) * ipt;
+
+    // d(r^2)/(2 dalpha), same fallback as for the steps.
+    const float dot  = x*cpsi(n, 0, 0) + y*spsi(n, 0, 0);
+    const float rdot = rho(n, 0, 0) * (dot > 0.1f*r0(n, 0, 0) ? dot : r0(n, 0, 0));
+    const float oord = rdot != 0.f ? 1.f/rdot : 0.f;
+
+    const float dadx   = -x*oord;
+    const float dady   = -y*oord;
+    const float dadipt = (x*(x - xin) + y*(y - yin))*oord/ipt;
+    const float dadphi = -(x*yin - y*xin)*oord;
+
+    dprint_np(n, "newton done r=" << msRad(n, 0, 0) << " r0=" << r0(n, 0, 0) << " alpha=" << alpha(n, 0, 0));
+
+    helixAtRJacobian_impl(inPar, outPar, errorProp, n, N_proc, k,
+                          std::cos(inPar(n, 4, 0)), std::sin(inPar(n, 4, 0)),
+                          alpha(n, 0, 0), dadx, dady, dadipt, dadphi);
+  }
+}
+
+void helixAtRFromIntersection(const MPlexLV& inPar,     const MPlexQI& inChg, const MPlexQF &msRad,
+                                    MPlexLV& outPar,          MPlexLL& errorProp,
+                              const int      N_proc,    const PropagationFlags pflags)
+{
+  helixAtRFromIntersection_impl(inPar, inChg, msRad, outPar, errorProp, N_proc, pflags);
+}
+
+
+void propagateHelixToRMPlex(const MPlexLS &inErr,  const MPlexLV& inPar,
+                            const MPlexQI &inChg,  const MPlexQF& msRad, 
+			          MPlexLS &outErr,       MPlexLV& outPar,
+                            const int      N_proc, const PropagationFlags pflags,
+                            const LayerInfo *layer)
+{
+   dispatchPropagationFlags(pflags, [&](auto pft) {
+     propagateHelixToRMPlex<decltype(pft)::pfe>(inErr, inPar, inChg, msRad, outErr, outPar, N_proc, layer);
+   });
+}
+
+template<int PFE>
 void propagateHelixToRMPlex(const MPlexLS &inErr,  const MPlexLV& inPar,
                             const MPlexQI &inChg,  const MPlexQF& msRad, 
 			          MPlexLS &outErr,       MPlexLV& outPar,
-                            const int      N_proc, const PropagationFlags pflags)
+                            const int      N_proc, const LayerInfo *layer)
 {
    // debug = true;
 
+   constexpr PropagationFlagsT<PFE> pflags {};
+
    // This is used further down when calculating similarity with errorProp (and before in DEBUG).
    // MT: I don't think this really needed if we use inErr where required.
    outErr = inErr;
-   // This requirement for helixAtRFromIterativeCCS_impl() and for helixAtRFromIterativeCCSFullJac().
+   // This requirement for helixAtRFromIterativeCCS_impl(), helixAtRFromIntersection() and for helixAtRFromIterativeCCSFullJac().
    // MT: This should be properly handled in both functions (expecting input in output parameters sucks).
    outPar = inPar;
 
    MPlexLL errorProp;
 
-   helixAtRFromIterativeCCS(inPar, inChg, msRad, outPar, errorProp, N_proc, pflags);
+   if (Config::useIterativeHelixAtR)
+   {
+     errorProp.SetVal(0.f);
+     helixAtRFromIterativeCCS_impl(inPar, inChg, msRad, outPar, errorProp, 0, NN, N_proc, pflags);
+   }
+   else
+   {
+     helixAtRFromIntersection_impl(inPar, inChg, msRad, outPar, errorProp, N_proc, pflags);
+   }
 
 #ifdef DEBUG
    {
@@ -442,15 +571,35 @@ void propagateHelixToRMPlex(const MPlexLS &inErr,  const MPlexLV& inPar,
      MPlexQF hitsRl;
      MPlexQF hitsXi;
      MPlexQF propSign;
+     if (layer)
+     {
+       const float *mat_rl = layer->m_mat_rl.data();
+       const float *mat_xi = layer->m_mat_xi.data();
+       const int    n_bins = layer->m_mat_rl.size();
 #pragma omp simd
-     for (int n = 0; n < NN; ++n) 
+       for (int n = 0; n < NN; ++n)
+       {
+         const int zbin = getZbinME(outPar(n, 2, 0));
+
+         hitsRl(n, 0, 0) = (zbin>=0 && zbin<n_bins) ? mat_rl[zbin] : 0.f;
+         hitsXi(n, 0, 0) = (zbin>=0 && zbin<n_bins) ? mat_xi[zbin] : 0.f;
+       }
+     }
+     else
      {
-       const int zbin = getZbinME(outPar(n, 2, 0));
-       const int rbin = getRbinME(msRad (n, 0, 0));
-       
-       hitsRl(n, 0, 0) = (zbin>=0 && zbin<Config::nBinsZME && rbin>=0 && rbin<Config::nBinsRME) ? getRlVal(zbin,rbin) : 0.f; // protect against crazy propagations
-       hitsXi(n, 0, 0) = (zbin>=0 && zbin<Config::nBinsZME && rbin>=0 && rbin<Config::nBinsRME) ? getXiVal(zbin,rbin) : 0.f; // protect against crazy propagations
+#pragma omp simd
+       for (int n = 0; n < NN; ++n)
+       {
+         const int zbin = getZbinME(outPar(n, 2, 0));
+         const int rbin = getRbinME(msRad (n, 0, 0));
 
+         hitsRl(n, 0, 0) = (zbin>=0 && zbin<Config::nBinsZME && rbin>=0 && rbin<Config::nBinsRME) ? getRlVal(zbin,rbin) : 0.f; // protect against crazy propagations
+         hitsXi(n, 0, 0) = (zbin>=0 && zbin<Config::nBinsZME && rbin>=0 && rbin<Config::nBinsRME) ? getXiVal(zbin,rbin) : 0.f; // protect against crazy propagations
+       }
+     }
+#pragma omp simd
+     for (int n = 0; n < NN; ++n) 
+     {
        const float r0 = hipo(inPar(n, 0, 0), inPar(n, 1, 0));
        const float r = msRad(n, 0, 0);
        propSign(n, 0, 0) = (r>r0 ? 1. : -1.);
@@ -506,19 +655,38 @@ void propagateHelixToRMPlex(const MPlexLS &inErr,  const MPlexLV& inPar,
 
 //==============================================================================
 
+template<typename TPF>
+static void helixAtZ_impl(const MPlexLV& inPar,  const MPlexQI& inChg, const MPlexQF &msZ,
+                                MPlexLV& outPar,       MPlexLL& errorProp,
+                          const int      N_proc, const TPF      pflags);
+
 void propagateHelixToZMPlex(const MPlexLS &inErr,  const MPlexLV& inPar,
                             const MPlexQI &inChg,  const MPlexQF& msZ,
 			          MPlexLS &outErr,       MPlexLV& outPar,
-                            const int      N_proc, const PropagationFlags pflags)
+                            const int      N_proc, const PropagationFlags pflags,
+                            const LayerInfo *layer)
+{
+   dispatchPropagationFlags(pflags, [&](auto pft) {
+     propagateHelixToZMPlex<decltype(pft)::pfe>(inErr, inPar, inChg, msZ, outErr, outPar, N_proc, layer);
+   });
+}
+
+template<int PFE>
+void propagateHelixToZMPlex(const MPlexLS &inErr,  const MPlexLV& inPar,
+                            const MPlexQI &inChg,  const MPlexQF& msZ,
+			          MPlexLS &outErr,       MPlexLV& outPar,
+                            const int      N_proc, const LayerInfo *layer)
 {
    // debug = true;
 
+   constexpr PropagationFlagsT<PFE> pflags {};
+
    outErr = inErr;
    outPar = inPar;
 
    MPlexLL errorProp;
 
-   helixAtZ(inPar, inChg, msZ, outPar, errorProp, N_proc, pflags);
+   helixAtZ_impl(inPar, inChg, msZ, outPar, errorProp, N_proc, pflags);
 
 #ifdef DEBUG
    {
@@ -543,15 +711,35 @@ void propagateHelixToZMPlex(const MPlexLS &inErr,  const MPlexLV& inPar,
      MPlexQF hitsRl;
      MPlexQF hitsXi;
      MPlexQF propSign;
-#pragma omp simd
-     for (int n = 0; n < NN; ++n) 
+     if (layer)
      {
-       const int zbin = getZbinME(msZ(n, 0, 0));
-       const int rbin = getRbinME(std::hypot(outPar(n, 0, 0), outPar(n, 1, 0)));
+       const float *mat_rl = layer->m_mat_rl.data();
+       const float *mat_xi = layer->m_mat_xi.data();
+       const int    n_bins = layer->m_mat_rl.size();
+#pragma omp simd
+       for (int n = 0; n < NN; ++n)
+       {
+         const int rbin = getRbinME(std::hypot(outPar(n, 0, 0), outPar(n, 1, 0)));
 
-       hitsRl(n, 0, 0) = (zbin>=0 && zbin<Config::nBinsZME && rbin>=0 && rbin<Config::nBinsRME) ? getRlVal(zbin,rbin) : 0.f; // protect against crazy propagations
-       hitsXi(n, 0, 0) = (zbin>=0 && zbin<Config::nBinsZME && rbin>=0 && rbin<Config::nBinsRME) ? getXiVal(zbin,rbin) : 0.f; // protect against crazy propagations
+         hitsRl(n, 0, 0) = (rbin>=0 && rbin<n_bins) ? mat_rl[rbin] : 0.f;
+         hitsXi(n, 0, 0) = (rbin>=0 && rbin<n_bins) ? mat_xi[rbin] : 0.f;
+       }
+     }
+     else
+     {
+#pragma omp simd
+       for (int n = 0; n < NN; ++n)
+       {
+         const int zbin = getZbinME(msZ(n, 0, 0));
+         const int rbin = getRbinME(std::hypot(outPar(n, 0, 0), outPar(n, 1, 0)));
 
+         hitsRl(n, 0, 0) = (zbin>=0 && zbin<Config::nBinsZME && rbin>=0 && rbin<Config::nBinsRME) ? getRlVal(zbin,rbin) : 0.f; // protect against crazy propagations
+         hitsXi(n, 0, 0) = (zbin>=0 && zbin<Config::nBinsZME && rbin>=0 && rbin<Config::nBinsRME) ? getXiVal(zbin,rbin) : 0.f; // protect against crazy propagations
+       }
+     }
+#pragma omp simd
+     for (int n = 0; n < NN; ++n) 
+     {
        const float zout = msZ.ConstAt(n, 0, 0);
        const float zin   = inPar.ConstAt(n, 2, 0);
        propSign(n, 0, 0) = (std::abs(zout)>std::abs(zin) ? 1. : -1.);
@@ -597,6 +785,14 @@ void propagateHelixToZMPlex(const MPlexLS &inErr,  const MPlexLV& inPar,
 void helixAtZ(const MPlexLV& inPar,  const MPlexQI& inChg, const MPlexQF &msZ,
                     MPlexLV& outPar,       MPlexLL& errorProp,
 	      const int      N_proc, const PropagationFlags pflags)
+{
+  helixAtZ_impl(inPar, inChg, msZ, outPar, errorProp, N_proc, pflags);
+}
+
+template<typename TPF>
+static void helixAtZ_impl(const MPlexLV& inPar,  const MPlexQI& inChg, const MPlexQF &msZ,
+                                MPlexLV& outPar,       MPlexLL& errorProp,
+                          const int      N_proc, const TPF      pflags)
 {
   errorProp.SetVal(0.f);
 
@@ -632,8 +828,9 @@ void helixAtZ(const MPlexLV& inPar,  const MPlexQI& inChg, const MPlexQF &msZ,
 
       float cosaTmp = 0., sinaTmp = 0.;
       //no trig approx here, phi can be large
-      const float cosP = std::cos(phiin), sinP = std::sin(phiin);
-      const float cosT = std::cos(theta), sinT = std::sin(theta);
+      float cosP, sinP, cosT, sinT;
+      fast_sincos(phiin, sinP, cosP);
+      fast_sincos(theta, sinT, cosT);
       const float pxin = cosP*pt;
       const float pyin = sinP*pt;
 
@@ -663,8 +860,8 @@ void helixAtZ(const MPlexLV& inPar,  const MPlexQI& inChg, const MPlexQF &msZ,
       dprint_np(n, std::endl << "outPar.At(n, 0, 0)=" << outPar.At(n, 0, 0) << " outPar.At(n, 1, 0)=" << outPar.At(n, 1, 0)
 		<< " pxin=" << pxin << " pyin=" << pyin);
 
-      const float sCosPsina = std::sin(cosP*sina);
-      const float cCosPsina = std::cos(cosP*sina);
+      float sCosPsina, cCosPsina;
+      fast_sincos(cosP*sina, sCosPsina, cCosPsina);
 
       errorProp(n,0,2) = cosP*sinT*(sinP*cosa*sCosPsina - cosa)/cosT;
       errorProp(n,0,3) = cosP*sinT*deltaZ*cosa*( 1.f - sinP*sCosPsina )/(cosT*ipt) - k*(cosP*sina - sinP*(1.f-cCosPsina))/(ipt*ipt);
@@ -709,11 +906,11 @@ void applyMaterialEffects(const MPlexQF &hitsRl, const MPlexQF& hitsXi, const MP
 #pragma omp simd
   for (int n = 0; n < NN; ++n)
     {
-      float radL = hitsRl.ConstAt(n,0,0);
-      if (radL < 1e-13f) continue;//ugly, please fixme
       const float theta = outPar.ConstAt(n,5,0);
       const float pt = 1.f/outPar.ConstAt(n,3,0);
-      const float p = pt/std::sin(theta);
+      float sinT, cosT;
+      fast_sincos(theta, sinT, cosT);
+      const float p = pt/sinT;
       const float p2 = p*p;
       constexpr float mpi = 0.140; // m=140 MeV, pion
       constexpr float mpi2 = mpi*mpi; // m=140 MeV, pion
@@ -721,33 +918,58 @@ void applyMaterialEffects(const MPlexQF &hitsRl, const MPlexQF& hitsXi, const MP
       const float beta = std::sqrt(beta2);
       //radiation lenght, corrected for the crossing angle (cos alpha from dot product of radius vector and momentum)
       const float invCos = p/pt;
-      radL = radL * invCos; //fixme works only for barrel geom
+      const float radL0 = hitsRl.ConstAt(n,0,0);
+      const float radL1 = radL0 * invCos; //fixme works only for barrel geom
+      // XXX-KMD radL < 0, see your fixme above!
+      // Lanes without material are left unchanged. There are no early exits and
+      // min/max/select go through FastMath bit-mask versions so that the loop
+      // vectorizes; radL is clamped to keep the unused terms finite.
+      // fast_sincos and fast_log differ from libm by up to ~1e-7, results are
+      // not bit-identical to the libm version.
+      const bool  has_mat = FastMath::fm_min(radL0, radL1) >= 1e-13f;
+      const float radL = FastMath::fm_max(radL1, 1e-13f);
       // multiple scattering
       //vary independently phi and theta by the rms of the planar multiple scattering angle
-      // XXX-KMD radL < 0, see your fixme above! Repeating bailout
-      if (radL < 1e-13f) continue;
-      const float thetaMSC = 0.0136f*std::sqrt(radL)*(1.f+0.038f*std::log(radL))/(beta*p);// eq 32.15
+      const float thetaMSC = 0.0136f*std::sqrt(radL)*(1.f+0.038f*fast_log(radL))/(beta*p);// eq 32.15
       const float thetaMSC2 = thetaMSC*thetaMSC;
-      outErr.At(n, 4, 4) += thetaMSC2;
-      outErr.At(n, 5, 5) += thetaMSC2;
       //std::cout << "beta=" << beta << " p=" << p << std::endl;
       //std::cout << "multiple scattering thetaMSC=" << thetaMSC << " thetaMSC2=" << thetaMSC2 << " radL=" << radL << std::endl;
       // energy loss
       // XXX-KMD beta2 = 1 => 1 / sqrt(0)
-      const float gamma = 1.f/std::sqrt(1.f - std::min(beta2, 0.999999f));
+      const float gamma = 1.f/std::sqrt(1.f - FastMath::fm_min(beta2, 0.999999f));
       const float gamma2 = gamma*gamma;
       constexpr float me = 0.0005; // m=0.5 MeV, electron
       const float wmax = 2.f*me*beta2*gamma2 / ( 1.f + 2.f*gamma*me/mpi + me*me/(mpi*mpi) );
       constexpr float I = 16.0e-9 * 10.75;
-      const float deltahalf = std::log(28.816e-9f * std::sqrt(2.33f*0.498f)/I) + std::log(beta*gamma) - 0.5f;
-      const float dEdx = beta<1.f ? (2.f*(hitsXi.ConstAt(n,0,0) * invCos * (0.5f*std::log(2.f*me*beta2*gamma2*wmax/(I*I)) - beta2 - deltahalf) / beta2)) : 0.f;//protect against infs and nans
+      const float deltahalf = std::log(28.816e-9f * std::sqrt(2.33f*0.498f)/I) + fast_log(beta*gamma) - 0.5f;
+      const float dEdxB = 2.f*(hitsXi.ConstAt(n,0,0) * invCos * (0.5f*fast_log(2.f*me*beta2*gamma2*wmax/(I*I)) - beta2 - deltahalf) / beta2);
+      const float dEdx = FastMath::fm_select(beta<1.f, dEdxB, 0.f);//protect against infs and nans
       // dEdx = dEdx*2.;//xi in cmssw is defined with an extra factor 0.5 with respect to formula 27.1 in pdg
       //std::cout << "dEdx=" << dEdx << " delta=" << deltahalf << " wmax=" << wmax << " Xi=" << hitsXi.ConstAt(n,0,0) << std::endl;
       const float dP = propSign.ConstAt(n,0,0)*dEdx/beta;
-      outPar.At(n, 3, 0) = p/((p+dP)*pt);
       //assume 100% uncertainty
-      outErr.At(n, 3, 3) += dP*dP/(p2*pt*pt);
+      const float err33 = outErr.ConstAt(n, 3, 3) + dP*dP/(p2*pt*pt);
+      const float err44 = outErr.ConstAt(n, 4, 4) + thetaMSC2;
+      const float err55 = outErr.ConstAt(n, 5, 5) + thetaMSC2;
+      const float ipt   = p/((p+dP)*pt);
+      outErr.At(n, 3, 3) = FastMath::fm_select(has_mat, err33, outErr.ConstAt(n, 3, 3));
+      outErr.At(n, 4, 4) = FastMath::fm_select(has_mat, err44, outErr.ConstAt(n, 4, 4));
+      outErr.At(n, 5, 5) = FastMath::fm_select(has_mat, err55, outErr.ConstAt(n, 5, 5));
+      outPar.At(n, 3, 0) = FastMath::fm_select(has_mat, ipt,   outPar.ConstAt(n, 3, 0));
     }
 }
 
+//==============================================================================
+
+#define INSTANTIATE_PROPAGATE_HELIX(PFE) \
+  template void propagateHelixToRMPlex<PFE>(const MPlexLS&, const MPlexLV&, const MPlexQI&, const MPlexQF&, \
+                                            MPlexLS&, MPlexLV&, const int, const LayerInfo*); \
+  template void propagateHelixToZMPlex<PFE>(const MPlexLS&, const MPlexLV&, const MPlexQI&, const MPlexQF&, \
+                                            MPlexLS&, MPlexLV&, const int, const LayerInfo*);
+
+INSTANTIATE_PROPAGATE_HELIX(PF_none)
+INSTANTIATE_PROPAGATE_HELIX(PF_use_param_b_field)
+INSTANTIATE_PROPAGATE_HELIX(PF_apply_material)
+INSTANTIATE_PROPAGATE_HELIX(PF_use_param_b_field | PF_apply_material)
+
 } // end namespace mkfit
@@ -5,6 +5,8 @@
 
 namespace mkfit {
 
+class LayerInfo;
+
 inline void squashPhiMPlex(MPlexLV& par, const int N_proc)
 {
   #pragma omp simd
@@ -27,10 +29,20 @@ void propagateLineToRMPlex(const MPlexLS &psErr,  const MPlexLV& psPar,
                                  MPlexLS &outErr,       MPlexLV& outPar,
                            const int      N_proc);
 
+// With material on, it is taken from the layer's table when the target layer is given
+// and from the global (z, r) grid otherwise.
+void propagateHelixToRMPlex(const MPlexLS &inErr,  const MPlexLV& inPar,
+                            const MPlexQI &inChg,  const MPlexQF& msRad,
+                                  MPlexLS &outErr,       MPlexLV& outPar,
+                            const int      N_proc, const PropagationFlags pflags,
+                            const LayerInfo *layer = nullptr);
+
+// Specialized on PropagationFlagsEnum values, instantiated for all of them.
+template<int PFE>
 void propagateHelixToRMPlex(const MPlexLS &inErr,  const MPlexLV& inPar,
                             const MPlexQI &inChg,  const MPlexQF& msRad,
                                   MPlexLS &outErr,       MPlexLV& outPar,
-                            const int      N_proc, const PropagationFlags pflags);
+                            const int      N_proc, const LayerInfo *layer);
 
 void helixAtRFromIterativeCCSFullJac(const MPlexLV& inPar, const MPlexQI& inChg, const MPlexQF &msRad,
                                            MPlexLV& outPar,      MPlexLL& errorProp,
@@ -40,10 +52,21 @@ void helixAtRFromIterativeCCS(const MPlexLV& inPar,  const MPlexQI& inChg, const
                                     MPlexLV& outPar,       MPlexLL& errorProp,
                               const int      N_proc, const PropagationFlags pflags);
 
+void helixAtRFromIntersection(const MPlexLV& inPar,  const MPlexQI& inChg, const MPlexQF &msRad,
+                                    MPlexLV& outPar,       MPlexLL& errorProp,
+                              const int      N_proc, const PropagationFlags pflags);
+
+void propagateHelixToZMPlex(const MPlexLS &inErr,  const MPlexLV& inPar,
+                            const MPlexQI &inChg,  const MPlexQF& msZ,
+                                  MPlexLS &outErr,       MPlexLV& outPar,
+                            const int      N_proc, const PropagationFlags pflags,
+                            const LayerInfo *layer = nullptr);
+
+template<int PFE>
 void propagateHelixToZMPlex(const MPlexLS &inErr,  const MPlexLV& inPar,
                             const MPlexQI &inChg,  const MPlexQF& msZ,
                                   MPlexLS &outErr,       MPlexLV& outPar,
-                            const int      N_proc, const PropagationFlags pflags);
+                            const int      N_proc, const LayerInfo *layer);
 
 void helixAtZ(const MPlexLV& inPar,  const MPlexQI& inChg, const MPlexQF &msZ,
                     MPlexLV& outPar,       MPlexLL& errorProp,
@@ -13,24 +13,28 @@ class MkFinder;
 
 #define COMPUTE_CHI2_ARGS const MPlexLS &,  const MPlexLV &, const MPlexQI &, \
                           const MPlexHS &,  const MPlexHV &, \
-                          MPlexQF &,  const int, const PropagationFlags
+                          MPlexQF &,  const int
 
 #define UPDATE_PARAM_ARGS const MPlexLS &,  const MPlexLV &, const MPlexQI &, \
                           const MPlexHS &,  const MPlexHV &, \
-                                MPlexLS &,        MPlexLV &, const int, const PropagationFlags
+                                MPlexLS &,        MPlexLV &, const int
+
+// Kernels are instantiations for the PropagationFlags in use: propagation to the
+// layer with Config::finding_inter_layer_pflags, chi2 and update with
+// Config::finding_intra_layer_pflags. See MkBuilder::setup_finding_foos().
 
 class FindingFoos
 {
 public:
   void (*m_compute_chi2_foo)      (COMPUTE_CHI2_ARGS);
   void (*m_update_param_foo)      (UPDATE_PARAM_ARGS);
-  void (MkBase::*m_propagate_foo) (float, const int, const PropagationFlags);
+  void (MkBase::*m_propagate_foo) (const LayerInfo&, const int);
 
   FindingFoos() {}
 
   FindingFoos(void (*cch2_f)      (COMPUTE_CHI2_ARGS),
               void (*updp_f)      (UPDATE_PARAM_ARGS),
-              void (MkBase::*p_f) (float, const int, const PropagationFlags)) :
+              void (MkBase::*p_f) (const LayerInfo&, const int)) :
     m_compute_chi2_foo(cch2_f),
     m_update_param_foo(updp_f),
     m_propagate_foo(p_f)
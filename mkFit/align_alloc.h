@@ -1,3 +1,6 @@
+#ifndef align_alloc_h
+#define align_alloc_h
+
 #include <cstdint>
 
 /**
@@ -141,3 +144,5 @@ class aligned_allocator
 	private:
 		aligned_allocator& operator=(const aligned_allocator&);
 };
+
+#endif
@@ -19,6 +19,8 @@
 
 #include <memory>
 
+#include "tbb/flow_graph.h"
+
 namespace mkfit {
 
 inline bool sortByHitsChi2(const std::pair<Track, TrackState>& cand1,
@@ -255,96 +257,103 @@ double runBuildingTestPlexBestHitGPU(Event& ev, MkBuilder& builder,
 
 double runBuildingTestPlexStandard(Event& ev, MkBuilder& builder)
 {
-  builder.begin_event(&ev, __func__);
+  const BuildingFinder finder = { __func__, &MkBuilder::FindTracksStandard };
 
-  builder.PrepareSeeds();
+  runBuildingHitsStage(ev, builder, finder);
 
-  builder.find_tracks_load_seeds();
+  runBuildingSeedsStage(builder);
 
-#ifdef USE_VTUNE_PAUSE
-  __SSC_MARK(0x111);  // use this to resume Intel SDE at the same point
-  __itt_resume();
-#endif
+  double time = runBuildingFindStage(ev, builder, finder);
 
-  double time = dtime();
+  runBuildingBackFitStage(ev, builder);
 
-  builder.FindTracksStandard();
+  runBuildingDuplicatesStage(builder);
 
-  time = dtime() - time;
+  runBuildingOutputStage(builder);
 
-#ifdef USE_VTUNE_PAUSE
-  __itt_pause();
-  __SSC_MARK(0x222);  // use this to pause Intel SDE at the same point
-#endif
+  // ev.print_tracks(ev.candidateTracks_, true);
 
-  check_nan_n_silly_candiates(ev);
+  return time;
+}
 
-  // first store candidate tracks
-  builder.quality_store_tracks(ev.candidateTracks_);
+//==============================================================================
+// runBuildTestPlex Combinatorial: CloneEngine TBB
+//==============================================================================
 
-  // now do backwards fit... do we want to time this section?
-  if (Config::backwardFit)
-  {
-    builder.BackwardFit();
+double runBuildingTestPlexCloneEngine(Event& ev, MkBuilder& builder)
+{
+  const BuildingFinder finder = { __func__, &MkBuilder::FindTracksCloneEngine };
 
-    check_nan_n_silly_bkfit(ev);
+  runBuildingHitsStage(ev, builder, finder);
 
-    if (Config::sim_val || Config::cmssw_val || Config::cmssw_export)
-    {
-      builder.quality_store_tracks(ev.fitTracks_);
-    }
-  }
+  runBuildingSeedsStage(builder);
 
-  builder.handle_duplicates();
+  double time = runBuildingFindStage(ev, builder, finder);
 
-  // validation section
-  if        (Config::quality_val) {
-    builder.quality_val();
-  } else if (Config::sim_val || Config::cmssw_val) { 
-    builder.root_val();
-  } else if (Config::cmssw_export) {
-    builder.cmssw_export();
-  }
+  runBuildingBackFitStage(ev, builder);
 
-  builder.end_event();
+  runBuildingDuplicatesStage(builder);
+
+  runBuildingOutputStage(builder);
 
   // ev.print_tracks(ev.candidateTracks_, true);
 
   return time;
 }
 
-//==============================================================================
-// runBuildTestPlex Combinatorial: CloneEngine TBB
-//==============================================================================
+//------------------------------------------------------------------------------
+// Combinatorial building stages
+//------------------------------------------------------------------------------
 
-double runBuildingTestPlexCloneEngine(Event& ev, MkBuilder& builder)
+void runBuildingHitsStage(Event& ev, MkBuilder& builder, const BuildingFinder& finder)
 {
-  builder.begin_event(&ev, __func__);
+  builder.begin_event(&ev, finder.m_name);
+}
 
+void runBuildingSeedsStage(MkBuilder& builder)
+{
   builder.PrepareSeeds();
 
   builder.find_tracks_load_seeds();
+}
+
+double runBuildingFindStage(Event& ev, MkBuilder& builder, const BuildingFinder& finder, int n_best)
+{
+  double best_time = 0;
+
+  for (int b = 0; b < n_best; ++b)
+  {
+    // Seeds were loaded by the seeds stage, reload them for repeated finding.
+    if (b > 0) builder.find_tracks_load_seeds();
 
 #ifdef USE_VTUNE_PAUSE
-  __SSC_MARK(0x111);  // use this to resume Intel SDE at the same point
-  __itt_resume();
+    __SSC_MARK(0x111);  // use this to resume Intel SDE at the same point
+    __itt_resume();
 #endif
-  double time = dtime();
+    double time = dtime();
 
-  builder.FindTracksCloneEngine();
+    (builder.*finder.m_find_tracks)();
 
-  time = dtime() - time;
+    time = dtime() - time;
 
 #ifdef USE_VTUNE_PAUSE
-  __itt_pause();
-  __SSC_MARK(0x222);  // use this to pause Intel SDE at the same point
+    __itt_pause();
+    __SSC_MARK(0x222);  // use this to pause Intel SDE at the same point
 #endif
 
+    best_time = (b == 0) ? time : std::min(time, best_time);
+  }
+
   check_nan_n_silly_candiates(ev);
 
   // first store candidate tracks
   builder.quality_store_tracks(ev.candidateTracks_);
 
+  return best_time;
+}
+
+void runBuildingBackFitStage(Event& ev, MkBuilder& builder)
+{
   // now do backwards fit... do we want to time this section?
   if (Config::backwardFit)
   {
@@ -357,9 +366,15 @@ double runBuildingTestPlexCloneEngine(Event& ev, MkBuilder& builder)
       builder.quality_store_tracks(ev.fitTracks_);
     }
   }
+}
 
+void runBuildingDuplicatesStage(MkBuilder& builder)
+{
   builder.handle_duplicates();
+}
 
+void runBuildingOutputStage(MkBuilder& builder)
+{
   // validation section
   if        (Config::quality_val) {
     builder.quality_val();
@@ -370,10 +385,103 @@ double runBuildingTestPlexCloneEngine(Event& ev, MkBuilder& builder)
   }
 
   builder.end_event();
+}
 
-  // ev.print_tracks(ev.candidateTracks_, true);
+//------------------------------------------------------------------------------
+// Combinatorial building as a flow graph
+//------------------------------------------------------------------------------
 
-  return time;
+double runBuildingTestPlexGraph(std::vector<EventSlot>& slots,
+                                const BuildingFinder& finder, int n_find,
+                                const std::function<void(int, const std::function<void(Event*)>&)>& request_event,
+                                const std::function<void(EventSlot&)>& event_done)
+{
+  // Each slot is a token circulating through the graph: the load node asks
+  // for the next event of the slot, the stages process it and the output node
+  // passes the slot back to load. Loading, hit preparation and output work on
+  // shared input / output and run one event at a time; while they do, other
+  // events are being found. Seeding, backward fit and duplicate removal are
+  // per-event and run concurrently. The find stage is limited separately so
+  // that events can be prepared ahead without all of them competing for the
+  // finding threads.
+  //
+  // The load node is an async node: a request that the loader can not serve
+  // yet completes later on the loader thread, no TBB worker waits for it.
+
+  using namespace tbb::flow;
+
+  typedef async_node<int, int>    load_node_t;
+  typedef function_node<int, int> stage_node_t;
+
+  graph g;
+
+  load_node_t load(g, serial,
+    [&](const int& s, load_node_t::gateway_type& gw)
+  {
+    gw.reserve_wait();
+    request_event(s, [&slots, &gw, s](Event *ev)
+    {
+      slots[s].m_event = ev;
+      if (ev) gw.try_put(s);
+      gw.release_wait();
+    });
+  });
+
+  stage_node_t hits(g, serial, [&](int s)
+  {
+    runBuildingHitsStage(*slots[s].m_event, *slots[s].m_builder, finder);
+    return s;
+  });
+
+  stage_node_t seeds(g, unlimited, [&](int s)
+  {
+    runBuildingSeedsStage(*slots[s].m_builder);
+    return s;
+  });
+
+  stage_node_t find(g, n_find > 0 ? (size_t) n_find : (size_t) unlimited, [&](int s)
+  {
+    slots[s].m_time = runBuildingFindStage(*slots[s].m_event, *slots[s].m_builder, finder,
+                                           Config::finderReportBestOutOfN);
+    return s;
+  });
+
+  stage_node_t backfit(g, unlimited, [&](int s)
+  {
+    runBuildingBackFitStage(*slots[s].m_event, *slots[s].m_builder);
+    return s;
+  });
+
+  stage_node_t dups(g, unlimited, [&](int s)
+  {
+    runBuildingDuplicatesStage(*slots[s].m_builder);
+    return s;
+  });
+
+  stage_node_t output(g, serial, [&](int s)
+  {
+    runBuildingOutputStage(*slots[s].m_builder);
+    event_done(slots[s]);
+    return s;
+  });
+
+  make_edge(load,    hits);
+  make_edge(hits,    seeds);
+  make_edge(seeds,   find);
+  make_edge(find,    backfit);
+  make_edge(backfit, dups);
+  make_edge(dups,    output);
+  make_edge(output,  load);
+
+  double time = dtime();
+
+  for (int s = 0; s < (int) slots.size(); ++s)
+  {
+    load.try_put(s);
+  }
+  g.wait_for_all();
+
+  return dtime() - time;
 }
 
 //==============================================================================
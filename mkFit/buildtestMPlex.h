@@ -7,6 +7,8 @@
 #include "BuilderCU.h"
 #endif
 
+#include <functional>
+
 namespace mkfit {
 
 class MkBuilder;
@@ -17,6 +19,44 @@ double runBuildingTestPlexStandard(Event& ev, MkBuilder& builder);
 double runBuildingTestPlexCloneEngine(Event& ev, MkBuilder& builder);
 double runBuildingTestPlexFV(Event& ev, MkBuilder& builder);
 
+// Combinatorial finder run by the stages below: name reported by
+// begin_event() and the MkBuilder find function.
+struct BuildingFinder
+{
+  const char  *m_name;
+  void (MkBuilder::*m_find_tracks)();
+};
+
+// Stages of runBuildingTestPlexCloneEngine, in order of execution. The find
+// stage repeats finding n_best times and returns the best time.
+void   runBuildingHitsStage      (Event& ev, MkBuilder& builder, const BuildingFinder& finder);
+void   runBuildingSeedsStage     (MkBuilder& builder);
+double runBuildingFindStage      (Event& ev, MkBuilder& builder, const BuildingFinder& finder, int n_best=1);
+void   runBuildingBackFitStage   (Event& ev, MkBuilder& builder);
+void   runBuildingDuplicatesStage(MkBuilder& builder);
+void   runBuildingOutputStage    (MkBuilder& builder);
+
+// Event processing slot for the flow graph; one event is in flight per slot.
+struct EventSlot
+{
+  Event     *m_event   = 0;
+  MkBuilder *m_builder = 0;
+  double     m_time    = 0; // finding time of the current event
+};
+
+// Runs combinatorial building over events as a TBB flow graph so that stages
+// of different events overlap. Loading, hit preparation and output are serial
+// nodes, the number of events in flight is the number of slots and at most
+// n_find of them are in the find stage at once (0 for no limit).
+// request_event(slot, ready) must call ready with the next event for the
+// slot, or nullptr when done, without blocking -- either right away or later
+// from another thread. event_done is called in the output stage. Finding is
+// repeated Config::finderReportBestOutOfN times. Returns elapsed time.
+double runBuildingTestPlexGraph(std::vector<EventSlot>& slots,
+                                const BuildingFinder& finder, int n_find,
+                                const std::function<void(int, const std::function<void(Event*)>&)>& request_event,
+                                const std::function<void(EventSlot&)>& event_done);
+
 #if USE_CUDA
 double runBuildingTestPlexBestHitGPU(Event& ev, MkBuilder& builder,
                                      BuilderCU& builder_cu);
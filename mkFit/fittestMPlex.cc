@@ -56,6 +56,7 @@ namespace mkfit {
 double runFittingTestPlex(Event& ev, std::vector<Track>& rectracks)
 {
    g_exe_ctx.populate(Config::numThreadsFinder);
+   ev.FillMappedHits();
    std::vector<Track>& simtracks = ev.simTracks_;
 
    const int Nhits = Config::nLayers;
@@ -201,6 +202,7 @@ double runFittingTestPlexGPU(FitterCU<float> &cuFitter,
   cudaMemcpyAsync(tracks_cu, &simtracks[0], simtracks.size()*sizeof(Track),
                   cudaMemcpyHostToDevice, cuFitter.get_stream());
 
+  ev.FillMappedHits();
   EventOfHitsCU events_of_hits_cu;
   events_of_hits_cu.reserve_layers(ev.layerHits_);
   events_of_hits_cu.copyFromCPU(ev.layerHits_, cuFitter.get_stream());
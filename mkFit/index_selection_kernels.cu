@@ -98,8 +98,8 @@ __device__ void selectHitIndices_fn(const LayerOfHitsCU &layer_of_hits,
         // Then enter vectorized loop to actually collect the hits in proper order.
 
         /*for (int hi = L.m_phi_bin_infos[zi][pb].first; hi < L.m_phi_bin_infos[zi][pb].second; ++hi)*/
-        for (int hi = L.m_phi_bin_infos[zi*Config::m_nphi + pb].first; 
-                 hi < L.m_phi_bin_infos[zi*Config::m_nphi + pb].second; ++hi)
+        for (int hi = L.m_phi_bin_infos[zi*L.m_nphi + pb].first; 
+                 hi < L.m_phi_bin_infos[zi*L.m_nphi + pb].second; ++hi)
         {
           // MT: Access into m_hit_zs and m_hit_phis is 1% run-time each.
 
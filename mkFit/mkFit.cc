@@ -5,6 +5,7 @@
 
 #include "MkBuilder.h"
 #include "MkFitter.h"
+#include "HitStructures.h"
 
 #include "Config.h"
 
@@ -16,6 +17,7 @@
 #include <memory>
 
 #include "Event.h"
+#include "EventLoader.h"
 
 #include "MaterialEffects.h"
 
@@ -29,7 +31,11 @@
 #include "gpu_utils.h"
 #endif
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <unistd.h>
 //#define DEBUG
 #include "Debug.h"
 
@@ -103,7 +109,14 @@ namespace
 
   std::string g_operation = "simulate_and_process";;
   std::string g_input_file = "";
+  bool        g_mmap_input = false;
+  int         g_read_ahead = 0;
+  bool        g_largest_first = false;
+  bool        g_flow_graph = false;
+  int         g_flow_graph_find = 0;
   std::string g_output_file = "";
+  std::string g_phi_bins_file = "";
+  std::string g_tune_phi_bins_file = "";
 
   seedOptsMap g_seed_opts;
   void init_seed_opts()
@@ -131,6 +144,48 @@ namespace
   }
 
   const char* b2a(bool b) { return b ? "true" : "false"; }
+
+#ifdef MKFIT_ISA_VARIANT
+  const char *g_isa_name = MKFIT_ISA_VARIANT;
+#else
+  const char *g_isa_name = "default";
+#endif
+
+#if defined(MULTI_ISA) && ! defined(MKFIT_ISA_VARIANT)
+  // With MULTI_ISA builds mkFit-avx512 and mkFit-avx2 are placed next to this
+  // binary. Re-executes the widest one supported by the CPU, returns if none is.
+  void dispatch_to_isa_variant(const char *argv[])
+  {
+    char self[PATH_MAX];
+    const ssize_t len = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (len <= 0) return;
+    self[len] = 0;
+
+    std::string dir(self);
+    dir.resize(dir.rfind('/') + 1);
+
+    auto try_exec = [&](const char *name)
+    {
+      const std::string exe = dir + name;
+      if (access(exe.c_str(), X_OK) != 0) return;
+
+      printf("Dispatching to ISA variant '%s'\n", exe.c_str());
+      fflush(stdout);
+      execv(exe.c_str(), const_cast<char* const*>(argv));
+      perror("execv of ISA variant failed");
+    };
+
+    __builtin_cpu_init();
+#if ! defined(__AVX512F__)
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512cd"))
+      try_exec("mkFit-avx512");
+#endif
+#if ! defined(__AVX512F__) && ! defined(__AVX2__)
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+      try_exec("mkFit-avx2");
+#endif
+  }
+#endif
 }
 
 //==============================================================================
@@ -249,6 +304,137 @@ void generate_and_save_tracks()
 
 //==============================================================================
 
+void tune_phi_bins()
+{
+  // Try all phi binnings for each layer on hits from the input file and keep
+  // the one with the lowest hit selection cost. Hits themselves are used as
+  // candidate positions, with search windows in the middle of layer's
+  // selection limits.
+  //
+  // The cost is counted, not timed, so the table does not depend on the
+  // machine or its load: each scanned hit costs one unit, each visited bin
+  // bin_cost units (bin info lookup and loop overhead). Timing of
+  // SelectHitIndices() is printed for information only. On equal cost the
+  // coarser binning is kept.
+
+  const int min_bits = 3, max_bits = LayerOfHits::m_phi_bits_fine, n_bits = max_bits - min_bits + 1;
+  const int max_cands_per_layer = 1000;
+  constexpr double bin_cost = 2;
+
+  struct Stats
+  {
+    double time = 0;
+    long   n_cands = 0, n_bins_visited = 0, n_hits_scanned = 0;
+    long   n_bins_filled = 0, n_hits = 0;
+
+    double cost() const { return bin_cost * n_bins_visited + n_hits_scanned; }
+  };
+
+  TrackerInfo &ti    = Config::TrkInfo;
+  const int    n_lay = ti.m_layers.size();
+
+  std::vector<std::vector<Stats>> stats(n_lay, std::vector<Stats>(n_bits));
+
+  DataFile data_file;
+  int n_ev = data_file.OpenRead(g_input_file);
+  if (Config::nEvents > 0) n_ev = std::min(n_ev, Config::nEvents);
+
+  Event ev(0);
+  std::vector<int> idcs;
+
+  for (int evt = 0; evt < n_ev; ++evt)
+  {
+    ev.Reset(evt);
+    ev.read_in(data_file);
+
+    for (int l = 0; l < n_lay && l < (int) ev.layerHits_.size(); ++l)
+    {
+      const HitVec &hits = ev.layerHits_[l];
+      if (hits.empty()) continue;
+
+      const int step = std::max(1, (int) hits.size() / max_cands_per_layer);
+
+      for (int b = 0; b < n_bits; ++b)
+      {
+        LayerInfo li = ti.m_layers[l];
+        li.m_phi_bits = min_bits + b;
+
+        LayerOfHits loh;
+        loh.SetupLayer(li);
+        loh.SuckInHits(hits);
+
+        const float dq   = 0.5f * (li.m_select_min_dq   + li.m_select_max_dq);
+        const float dphi = 0.5f * (li.m_select_min_dphi + li.m_select_max_dphi);
+
+        Stats &st = stats[l][b];
+
+        for (auto &pbi : loh.m_phi_bin_infos)
+        {
+          if (pbi.second > pbi.first) { ++st.n_bins_filled; st.n_hits += pbi.second - pbi.first; }
+        }
+
+        double t0 = dtime();
+        for (int i = 0; i < (int) hits.size(); i += step)
+        {
+          const float q = li.is_barrel() ? hits[i].z() : hits[i].r();
+          idcs.clear();
+          loh.SelectHitIndices(q, hits[i].phi(), dq, dphi, idcs);
+        }
+        st.time += dtime() - t0;
+
+        for (int i = 0; i < (int) hits.size(); i += step)
+        {
+          const float q = li.is_barrel() ? hits[i].z() : hits[i].r();
+          const float phi = hits[i].phi();
+          const int qb1 = loh.GetQBinChecked(q - dq), qb2 = loh.GetQBinChecked(q + dq) + 1;
+          const int pb1 = loh.GetPhiBin(phi - dphi),  pb2 = loh.GetPhiBin(phi + dphi) + 1;
+          for (int qi = qb1; qi < qb2; ++qi)
+          {
+            for (int pi = pb1; pi < pb2; ++pi)
+            {
+              const auto &pbi = loh.phi_bin_info(qi, pi & loh.m_phi_mask);
+              st.n_hits_scanned += pbi.second - pbi.first;
+            }
+          }
+          st.n_bins_visited += (qb2 - qb1) * (pb2 - pb1);
+          ++st.n_cands;
+        }
+      }
+    }
+  }
+
+  data_file.Close();
+
+  printf("Layer  bits  hits/filled-bin  bins/cand  hits-scanned/cand  cost/cand  ns/cand\n");
+  for (int l = 0; l < n_lay; ++l)
+  {
+    int best = -1;
+    for (int b = 0; b < n_bits; ++b)
+    {
+      const Stats &st = stats[l][b];
+      if (st.n_cands == 0) continue;
+      if (best < 0 || st.cost() < stats[l][best].cost()) best = b;
+    }
+    if (best < 0) continue;
+
+    ti.m_layers[l].m_phi_bits = min_bits + best;
+
+    const Stats &st = stats[l][best];
+    printf("%5d  %4d  %15.2f  %9.2f  %17.2f  %9.2f  %7.1f\n", l, min_bits + best,
+           (double) st.n_hits / std::max(1l, st.n_bins_filled),
+           (double) st.n_bins_visited / st.n_cands,
+           (double) st.n_hits_scanned / st.n_cands,
+           st.cost() / st.n_cands,
+           1e9 * st.time / st.n_cands);
+  }
+
+  if ( ! ti.write_phi_bins(g_tune_phi_bins_file)) exit(1);
+
+  printf("Phi binning table written to '%s'\n", g_tune_phi_bins_file.c_str());
+}
+
+//==============================================================================
+
 void test_standard()
 {
   printf("Running test_standard(), operation=\"%s\"\n", g_operation.c_str());
@@ -273,10 +459,30 @@ void test_standard()
   Geometry geom;
   initGeom(geom);
 
+  if ( ! g_phi_bins_file.empty() && ! Config::TrkInfo.read_phi_bins(g_phi_bins_file))
+  {
+    exit(1);
+  }
+
+  if ( ! g_tune_phi_bins_file.empty())
+  {
+    if (g_operation != "read")
+    {
+      fprintf(stderr, "--tune-phi-bins requires --input-file.\n");
+      exit(1);
+    }
+    tune_phi_bins();
+    return;
+  }
+
   DataFile data_file;
   if (g_operation == "read")
   {
     int evs_in_file   = data_file.OpenRead(g_input_file);
+    if (g_mmap_input && data_file.MapFile())
+    {
+      evs_in_file = data_file.f_index.size();
+    }
     int evs_available = evs_in_file - g_start_event + 1;
     if (Config::nEvents == -1)
     {
@@ -293,9 +499,25 @@ void test_standard()
     {
       data_file.SkipNEvents(g_start_event - 1);
     }
+
+    if (g_largest_first)
+    {
+      if (data_file.HasEventIndex())
+      {
+        data_file.OrderEventsLargestFirst(Config::nEvents);
+      }
+      else
+      {
+        printf("Input file has no event index, --largest-first ignored (it can be used with --mmap-input).\n");
+      }
+    }
   }
 
-  if (Config::useCMSGeom) fillZRgridME();
+  if (Config::useCMSGeom)
+  {
+    fillZRgridME();
+    Config::TrkInfo.fill_material_tables();
+  }
 
   const int NT = 5;
   double t_sum[NT] = {0};
@@ -342,7 +564,7 @@ void test_standard()
     std::cout << "Total best hit time (GPU): " << total_best_hit_time << std::endl;
   }
 #else
-  std::atomic<int> nevt{g_start_event};
+  std::atomic<int> next_evt{0};
   std::atomic<int> seedstot{0}, simtrackstot{0}, candstot{0};
   std::atomic<int> maxHits_all{0}, maxLayer_all{0};
 
@@ -370,7 +592,9 @@ void test_standard()
     mkbs[i].reset(MkBuilder::make_builder());
     evs[i].reset(new Event(geom, *vals[i], 0));
     if (g_operation == "read") {
-      fps.emplace_back(fopen(g_input_file.c_str(), "r"), [](FILE* fp) { if (fp) fclose(fp); });
+      // Mapped files are read without stdio, no per-thread file handles needed.
+      fps.emplace_back(data_file.IsMapped() ? nullptr : fopen(g_input_file.c_str(), "r"),
+                       [](FILE* fp) { if (fp) fclose(fp); });
     }
 #if USE_CUDA
     constexpr int gplex_width = 10000;
@@ -386,121 +610,273 @@ void test_standard()
 #endif
   }
 
-  tbb::task_scheduler_init tbb_init(Config::numThreadsFinder);
+  // With read-ahead, events are decoded on a loader thread into a pool of
+  // g_read_ahead events per event thread and handed out as they become ready.
+  std::unique_ptr<EventLoader> loader;
+  if (g_operation == "read" && g_read_ahead > 0)
+  {
+    loader.reset(new EventLoader(data_file, g_input_file, Config::numThreadsEvents,
+                                 Config::nEvents, g_start_event));
+    for (int i = 0; i < Config::numThreadsEvents; ++i)
+    {
+      for (int j = 0; j < g_read_ahead; ++j)
+      {
+        loader->AddEvent(i, std::unique_ptr<Event>(new Event(geom, *vals[i], 0)));
+      }
+    }
+  }
 
-  dprint("parallel_for step size " << (Config::nEvents+Config::numThreadsEvents-1)/Config::numThreadsEvents);
+  tbb::task_scheduler_init tbb_init(Config::numThreadsFinder);
 
   time = dtime();
 
-  int events_per_thread = (Config::nEvents+Config::numThreadsEvents-1)/Config::numThreadsEvents;
-  tbb::parallel_for(tbb::blocked_range<int>(0, Config::numThreadsEvents, 1),
-    [&](const tbb::blocked_range<int>& threads)
+  if (loader) loader->Start();
+
+  auto print_processing = [&](Event *evp)
   {
-    int thisthread = threads.begin();
+    if (!Config::silent)
+    {
+      std::lock_guard<std::mutex> printlock(Event::printmutex);
+      printf("\n");
+      printf("Processing event %d\n", evp->evtID());
+    }
+  };
 
-    assert(threads.begin() == threads.end()-1 && thisthread < Config::numThreadsEvents);
+  // Counts an event that was read in or simulated. Returns false for events
+  // without seeds, these are skipped.
+  auto accept_event = [&](Event *evp) -> bool
+  {
+    // skip events with zero seed tracks!
+    if (evp->is_trackvec_empty(evp->seedTracks_)) return false;
 
-    std::vector<Track> plex_tracks;
-    auto& ev     = *evs[thisthread].get();
-    auto& mkb    = *mkbs[thisthread].get();
-    auto  fp     =  fps[thisthread].get();
+    simtrackstot += evp->simTracks_.size();
+    seedstot     += evp->seedTracks_.size();
 
-    int evstart = thisthread*events_per_thread;
-    int evend   = std::min(Config::nEvents, evstart+events_per_thread);
+    return true;
+  };
 
-#if USE_CUDA
-    auto& cuFitter = *cuFitters[thisthread].get();
-    auto& cuBuilder = *cuBuilders[thisthread].get();
-#endif
+  // Returns the next event to be processed in the event slot, read in or
+  // simulated, or nullptr when there are no more events. Events are not
+  // partitioned between slots up-front, each slot takes the next event when
+  // it is done with the previous one so slots that draw heavy events do not
+  // hold back the end of the job. Events without seeds are skipped.
+  auto next_event = [&](int slot) -> Event*
+  {
+    while (true)
+    {
+      // The loader hands out events in read order and signals the end itself.
+      // With --largest-first evtID is the one the event has in sequential
+      // reading and the event is read by its index.
+      Event *evp;
+      int    i_file = -1;
+      if (loader)
+      {
+        evp = loader->Get(slot);
+        if ( ! evp) return nullptr;
+      }
+      else
+      {
+        int i_ev = next_evt++;
+        if (i_ev >= Config::nEvents) return nullptr;
+        if (g_operation == "read" && data_file.HasReadOrder())
+        {
+          i_ev   = data_file.ReadOrderSeq(i_ev);
+          i_file = data_file.SeqEventIndex(i_ev);
+        }
+        evp = evs[slot].get();
+        evp->Reset(g_start_event + i_ev);
+      }
 
-    dprint("thisthread " << thisthread << " events " << Config::nEvents << " events/thread " << events_per_thread
-                         << " range " << evstart << ":" << evend);
+      print_processing(evp);
 
-    for (int evt = evstart; evt < evend; ++evt)
-    {
-      ev.Reset(nevt++);
+      if (loader)
+      {
+        // already read in by the loader
+      }
+      else if (g_operation == "read")
+      {
+        evp->read_in(data_file, fps[slot].get(), i_file);
+      }
+      else
+      {
+        evp->Simulate();
+      }
 
-      if (!Config::silent)
+      if ( ! accept_event(evp))
       {
-        std::lock_guard<std::mutex> printlock(Event::printmutex);
-        printf("\n");
-        printf("Processing event %d\n", ev.evtID());
+        if (loader) loader->Recycle(slot, evp);
+        continue;
       }
 
-      if (g_operation == "read")
+      return evp;
+    }
+  };
+
+  if (g_flow_graph)
+  {
+    // One finder, clone engine unless another one is selected, with
+    // --num-thr-ev events in flight.
+    BuildingFinder finder = { "runBuildingTestPlexCloneEngine", &MkBuilder::FindTracksCloneEngine };
+    int         t_idx  = 3;
+    const char *t_name = "CEMX";
+    if (g_run_build_std)
+    {
+      finder = { "runBuildingTestPlexStandard", &MkBuilder::FindTracksStandard };
+      t_idx  = 2;
+      t_name = "STDMX";
+    }
+    else if (g_run_build_fv)
+    {
+      finder = { "runBuildingTestPlexFV", &MkBuilder::FindTracksFV };
+      t_idx  = 4;
+      t_name = "FVMX";
+    }
+
+    std::vector<EventSlot> slots(Config::numThreadsEvents);
+    for (int i = 0; i < Config::numThreadsEvents; ++i)
+    {
+      slots[i].m_builder = mkbs[i].get();
+    }
+
+    // Events are taken from the loader without blocking. The callback can run
+    // on the loader thread; the slot is idle then so its Validation is free.
+    std::function<void(int, const std::function<void(Event*)>&)> request_event =
+      [&](int slot, const std::function<void(Event*)> &ready)
+    {
+      if ( ! loader)
       {
-        ev.read_in(data_file, fp);
+        ready(next_event(slot));
+        return;
       }
-      else
+      loader->GetAsync(slot, [&, slot, ready](Event *evp)
       {
-        ev.Simulate();
+        if (evp) print_processing(evp);
+        if (evp && ! accept_event(evp))
+        {
+          loader->Recycle(slot, evp);
+          request_event(slot, ready);
+          return;
+        }
+        if (evp) evp->ResetValidation();
+        ready(evp);
+      });
+    };
+
+    std::mutex sum_mutex;
+
+    runBuildingTestPlexGraph(slots, finder, g_flow_graph_find, request_event,
+      [&](EventSlot &slot)
+    {
+      candstot += slot.m_builder->total_cands();
+      auto const& ln = slot.m_builder->max_hits_layer();
+      if (ln.first > maxHits_all) {
+        maxHits_all = ln.first;
+        maxLayer_all = ln.second;
       }
 
-      // skip events with zero seed tracks!
-      if (ev.is_trackvec_empty(ev.seedTracks_)) continue;
+      if (!Config::silent) {
+        std::lock_guard<std::mutex> printlock(Event::printmutex);
+        printf("Event %d  %s = %.5f\n", slot.m_event->evtID(), t_name, slot.m_time);
+      }
 
-      plex_tracks.resize(ev.simTracks_.size());
+      {
+        std::lock_guard<std::mutex> sumlock(sum_mutex);
+        t_sum[t_idx] += slot.m_time;
+        if (slot.m_event->evtID() > g_start_event) t_skip[t_idx] += slot.m_time;
+      }
 
-      double t_best[NT] = {0}, t_cur[NT];
-      simtrackstot += ev.simTracks_.size();
-      seedstot     += ev.seedTracks_.size();
+      if (loader) loader->Recycle(&slot - &slots[0], slot.m_event);
+    });
+  }
+  else
+  {
+    tbb::parallel_for(tbb::blocked_range<int>(0, Config::numThreadsEvents, 1),
+      [&](const tbb::blocked_range<int>& threads)
+    {
+      int thisthread = threads.begin();
+
+      assert(threads.begin() == threads.end()-1 && thisthread < Config::numThreadsEvents);
+
+      std::vector<Track> plex_tracks;
+      auto& mkb    = *mkbs[thisthread].get();
+
+#if USE_CUDA
+      auto& cuFitter = *cuFitters[thisthread].get();
+      auto& cuBuilder = *cuBuilders[thisthread].get();
+#endif
 
-      int ncands_thisthread = 0;
-      int maxHits_thisthread = 0;
-      int maxLayer_thisthread = 0;
-      for (int b = 0; b < Config::finderReportBestOutOfN; ++b)
+      dprint("thisthread " << thisthread << " events " << Config::nEvents);
+
+      while (Event *evp = next_event(thisthread))
       {
+        auto& ev  = *evp;
+        const int evt = ev.evtID() - g_start_event;
+
+        plex_tracks.resize(ev.simTracks_.size());
+
+        double t_best[NT] = {0}, t_cur[NT];
+
+        int ncands_thisthread = 0;
+        int maxHits_thisthread = 0;
+        int maxLayer_thisthread = 0;
+        for (int b = 0; b < Config::finderReportBestOutOfN; ++b)
+        {
   #ifndef USE_CUDA
-        t_cur[0] = (g_run_fit_std) ? runFittingTestPlex(ev, plex_tracks) : 0;
-        t_cur[1] = (g_run_build_all || g_run_build_bh)  ? runBuildingTestPlexBestHit(ev, mkb) : 0;
-        t_cur[3] = (g_run_build_all || g_run_build_ce)  ? runBuildingTestPlexCloneEngine(ev, mkb) : 0;
-        t_cur[4] = (g_run_build_all || g_run_build_fv)  ? runBuildingTestPlexFV(ev, mkb) : 0;
+          t_cur[0] = (g_run_fit_std) ? runFittingTestPlex(ev, plex_tracks) : 0;
+          t_cur[1] = (g_run_build_all || g_run_build_bh)  ? runBuildingTestPlexBestHit(ev, mkb) : 0;
+          t_cur[3] = (g_run_build_all || g_run_build_ce)  ? runBuildingTestPlexCloneEngine(ev, mkb) : 0;
+          t_cur[4] = (g_run_build_all || g_run_build_fv)  ? runBuildingTestPlexFV(ev, mkb) : 0;
 	if (g_run_build_all || g_run_build_cmssw) runBuildingTestPlexDumbCMSSW(ev, mkb);
   #else
-        t_cur[0] = (g_run_fit_std) ? runFittingTestPlexGPU(cuFitter, ev, plex_tracks) : 0;
-        t_cur[1] = (g_run_build_all || g_run_build_bh)  ? runBuildingTestPlexBestHitGPU(ev, mkb, cuBuilder) : 0;
-        // XXXX MT note for Matthieu: ev_tmp no longer exists ----------------------------------v
-        t_cur[3] = (g_run_build_all || g_run_build_ce)  ? runBuildingTestPlexCloneEngineGPU(ev, ev_tmp, mkb, cuBuilder, g_seed_based) : 0;
+          t_cur[0] = (g_run_fit_std) ? runFittingTestPlexGPU(cuFitter, ev, plex_tracks) : 0;
+          t_cur[1] = (g_run_build_all || g_run_build_bh)  ? runBuildingTestPlexBestHitGPU(ev, mkb, cuBuilder) : 0;
+          // XXXX MT note for Matthieu: ev_tmp no longer exists ----------------------------------v
+          t_cur[3] = (g_run_build_all || g_run_build_ce)  ? runBuildingTestPlexCloneEngineGPU(ev, ev_tmp, mkb, cuBuilder, g_seed_based) : 0;
   #endif
-        t_cur[2] = (g_run_build_all || g_run_build_std) ? runBuildingTestPlexStandard(ev, mkb) : 0;
-        if (g_run_build_ce){
-          ncands_thisthread = mkb.total_cands();
-          auto const& ln = mkb.max_hits_layer();
-          maxHits_thisthread = ln.first;
-          maxLayer_thisthread = ln.second;
+          t_cur[2] = (g_run_build_all || g_run_build_std) ? runBuildingTestPlexStandard(ev, mkb) : 0;
+          if (g_run_build_ce){
+            ncands_thisthread = mkb.total_cands();
+            auto const& ln = mkb.max_hits_layer();
+            maxHits_thisthread = ln.first;
+            maxLayer_thisthread = ln.second;
+          }
+          for (int i = 0; i < NT; ++i) t_best[i] = (b == 0) ? t_cur[i] : std::min(t_cur[i], t_best[i]);
+
+          if (!Config::silent) {
+            std::lock_guard<std::mutex> printlock(Event::printmutex);
+            if (Config::finderReportBestOutOfN > 1)
+            {
+              printf("----------------------------------------------------------------\n");
+              printf("Best-of-times:");
+              for (int i = 0; i < NT; ++i) printf("  %.5f/%.5f", t_cur[i], t_best[i]);
+              printf("\n");
+            }
+            printf("----------------------------------------------------------------\n");
+          }
         }
-        for (int i = 0; i < NT; ++i) t_best[i] = (b == 0) ? t_cur[i] : std::min(t_cur[i], t_best[i]);
 
+        candstot += ncands_thisthread;
+        if (maxHits_thisthread > maxHits_all){
+          maxHits_all = maxHits_thisthread;
+          maxLayer_all = maxLayer_thisthread;
+        }
         if (!Config::silent) {
           std::lock_guard<std::mutex> printlock(Event::printmutex);
-          if (Config::finderReportBestOutOfN > 1)
-          {
-            printf("----------------------------------------------------------------\n");
-            printf("Best-of-times:");
-            for (int i = 0; i < NT; ++i) printf("  %.5f/%.5f", t_cur[i], t_best[i]);
-            printf("\n");
-          }
-          printf("----------------------------------------------------------------\n");
+          printf("Matriplex fit = %.5f  --- Build  BHMX = %.5f  STDMX = %.5f  CEMX = %.5f  FVMX = %.5f\n",
+                 t_best[0], t_best[1], t_best[2], t_best[3], t_best[4]);
         }
-      }
 
-      candstot += ncands_thisthread;
-      if (maxHits_thisthread > maxHits_all){
-        maxHits_all = maxHits_thisthread;
-        maxLayer_all = maxLayer_thisthread;
-      }
-      if (!Config::silent) {
-        std::lock_guard<std::mutex> printlock(Event::printmutex);
-        printf("Matriplex fit = %.5f  --- Build  BHMX = %.5f  STDMX = %.5f  CEMX = %.5f  FVMX = %.5f\n",
-               t_best[0], t_best[1], t_best[2], t_best[3], t_best[4]);
+        // not protected by a mutex, may be inacccurate for multiple events in flight;
+        // probably should convert to a scaled long so can use std::atomic<Integral>
+        for (int i = 0; i < NT; ++i) t_sum[i] += t_best[i];
+        if (evt > 0) for (int i = 0; i < NT; ++i) t_skip[i] += t_best[i];
+
+        if (loader) loader->Recycle(thisthread, evp);
       }
+    }, tbb::simple_partitioner());
+  }
 
-      // not protected by a mutex, may be inacccurate for multiple events in flight;
-      // probably should convert to a scaled long so can use std::atomic<Integral>
-      for (int i = 0; i < NT; ++i) t_sum[i] += t_best[i];
-      if (evt > 0) for (int i = 0; i < NT; ++i) t_skip[i] += t_best[i];
-    }
-  }, tbb::simple_partitioner());
+  loader.reset();
 
 #endif
   time = dtime() - time;
@@ -516,6 +892,23 @@ void test_standard()
          t_skip[0], t_skip[1], t_skip[2], t_skip[3], t_skip[4]);
   printf("Total event loop time %.5f simtracks %d seedtracks %d builtcands %d maxhits %d on lay %d\n", time, 
          simtrackstot.load(), seedstot.load(), candstot.load(), maxHits_all.load(), maxLayer_all.load());
+  if (Config::finderLaneStats)
+  {
+    printf("Finding scratch buffer growths %lld, seed hit-node arena growths %lld\n",
+           g_exe_ctx.m_scratch_grow_count.load(), g_exe_ctx.m_hots_grow_count.load());
+
+    long long n_cands = 0, n_batches = 0;
+    printf("Finding lane utilization per layer (%d lanes):\n", NN);
+    for (int l = 0; l < ExecutionContext::s_max_lane_stat_layers; ++l)
+    {
+      const long long nc = g_exe_ctx.m_lane_cands[l], nb = g_exe_ctx.m_lane_batches[l];
+      if (nb == 0) continue;
+      printf("  layer %3d  %6.2f%%  cands %10lld  batches %9lld\n", l, 100.0 * nc / (nb * NN), nc, nb);
+      n_cands += nc; n_batches += nb;
+    }
+    if (n_batches > 0)
+      printf("  all        %6.2f%%  cands %10lld  batches %9lld\n", 100.0 * n_cands / (n_batches * NN), n_cands, n_batches);
+  }
   //fflush(stdout);
 
   if (g_operation == "read")
@@ -570,6 +963,14 @@ void next_arg_or_die(lStr_t& args, lStr_i& i, bool allow_single_minus=false)
 
 int main(int argc, const char *argv[])
 {
+#if defined(MULTI_ISA) && ! defined(MKFIT_ISA_VARIANT)
+  if (std::find_if(argv + 1, argv + argc, [](const char *a) { return strcmp(a, "--no-isa-dispatch") == 0; })
+      == argv + argc)
+  {
+    dispatch_to_isa_variant(argv);
+  }
+#endif
+
   if (Config::nan_etc_sigs_enable)
   {
     feenableexcept(FE_DIVBYZERO | FE_INVALID | FE_OVERFLOW); //FE_ALL_EXCEPT);
@@ -606,16 +1007,25 @@ int main(int argc, const char *argv[])
 	"\n----------------------------------------------------------------------------------------------------------\n\n"
 	"Generic options\n\n"
         "  --geom           <str>   geometry plugin to use (def: %s)\n"
+        "  --no-isa-dispatch        do not start the mkFit-avx512 / mkFit-avx2 variant of a MULTI_ISA build\n"
+        "                             when the CPU supports it (running: %s, %d-wide Matriplex)\n"
         "  --silent                 suppress printouts inside event loop (def: %s)\n"
         "  --best-out-of    <int>   run test num times, report best time (def: %d)\n"
         "  --input-file             file name for reading (def: %s)\n"
         "  --output-file            file name for writitng (def: %s)\n"
+        "  --phi-bins       <file>  read per-layer phi binning table (def: '%s')\n"
+        "  --tune-phi-bins  <file>  count bins and hits visited in hit selection with different phi binnings on events\n"
+        "                             from --input-file and write the cheapest per-layer phi binning table to <file>\n"
         "  --read-cmssw-tracks      read external cmssw reco tracks if available (def: %s)\n"
 	"  --read-simtrack-states   read in simTrackStates for pulls in validation (def: %s)\n"
         "  --num-events     <int>   number of events to run over or simulate (def: %d)\n"
         "                             if using --input-file, must be enabled AFTER on command line\n"
         "  --start-event    <int>   event number to start at when reading from a file (def: %d)\n"
         "  --loop-over-file         after reaching the end of the file, start over from the beginning until <num-events> events have been processed\n"
+        "  --mmap-input             memory-map the input file and read events from the mapping without locking (def: %s)\n"
+        "  --read-ahead     <int>   number of events per event thread to read ahead on a separate loader thread (def: %d)\n"
+        "                             0 means events are read in the event loop\n"
+        "  --largest-first          process events in order of decreasing number of hits, requires event index (def: %s)\n"
 	"\n"
 	"If no --input-file is specified, will trigger simulation\n"
         "  --num-tracks     <int>   number of tracks to generate for each event (def: %d)\n"
@@ -624,7 +1034,12 @@ int main(int argc, const char *argv[])
         "  --num-thr-sim    <int>   number of threads for simulation (def: %d)\n"
         "  --num-thr        <int>   number of threads for track finding (def: %d)\n"
         "  --num-thr-ev     <int>   number of threads to run the event loop (def: %d)\n"
+        "  --flow-graph             run Std, CE or FV building (CE by default) as a TBB flow graph of per-event\n"
+        "                             stages, with <num-thr-ev> events in flight; other tests are not run (def: %s)\n"
+        "  --flow-graph-find <int>  max number of events in the find stage of the flow graph, 0 for all (def: %d)\n"
         "  --seeds-per-task <int>   number of seeds to process in a tbb task (def: %d)\n"
+        "  --fill-lanes             do not split seeds into tasks too small to fill all vector lanes (def: %s)\n"
+        "  --lane-stats             print per-layer vector lane utilization and buffer growths of Std and CE finding (def: %s)\n"
         "  --hits-per-task  <int>   number of layer1 hits per task when using find seeds (def: %d)\n"
 	"\n----------------------------------------------------------------------------------------------------------\n\n"
 	"FittingTestMPlex options\n\n"
@@ -656,6 +1071,7 @@ int main(int argc, const char *argv[])
         "  --kludge-cms-hit-errors  make sure err(xy) > 15 mum, err(z) > 30 mum (def: %s)\n"
         "  --backward-fit           perform backward fit during building (def: %s)\n"
         "  --include-pca            do the backward fit to point of closest approach, does not imply '--backward-fit' (def: %s)\n"
+        "  --iterative-helix-r      propagate to R with fixed-count iterations instead of Newton steps (def: %s)\n"
 	"\n----------------------------------------------------------------------------------------------------------\n\n"
 	"Validation options\n\n"
 	" **Text file based options\n"
@@ -727,20 +1143,29 @@ int main(int argc, const char *argv[])
         argv[0],
 
         Config::geomPlugin.c_str(),
+        g_isa_name, NN,
         b2a(Config::silent),
         Config::finderReportBestOutOfN,
       	g_input_file.c_str(),
       	g_output_file.c_str(),
+        g_phi_bins_file.c_str(),
 	b2a(Config::readCmsswTracks),
         b2a(Config::readSimTrackStates),
 	Config::nEvents,
         g_start_event,
+        b2a(g_mmap_input),
+        g_read_ahead,
+        b2a(g_largest_first),
         Config::nTracks,
 
         Config::numThreadsSimulation, 
 	Config::numThreadsFinder, 
 	Config::numThreadsEvents,
+        b2a(g_flow_graph),
+        g_flow_graph_find,
         Config::numSeedsPerTask,
+        b2a(Config::finderFillLanes),
+        b2a(Config::finderLaneStats),
 	Config::numHitsPerTask,
 
 	b2a(g_run_fit_std),
@@ -766,6 +1191,7 @@ int main(int argc, const char *argv[])
         b2a(Config::kludgeCmsHitErrors),
         b2a(Config::backwardFit),
         b2a(Config::includePCA),
+        b2a(Config::useIterativeHelixAtR),
 
         b2a(Config::quality_val),
         b2a(Config::dumpForPlots),
@@ -822,6 +1248,10 @@ int main(int argc, const char *argv[])
       next_arg_or_die(mArgs, i);
       Config::geomPlugin = *i;
     }
+    else if (*i == "--no-isa-dispatch")
+    {
+      // handled at the start of main()
+    }
     else if (*i == "--silent")
     {
       Config::silent = true;
@@ -844,6 +1274,16 @@ int main(int argc, const char *argv[])
       g_output_file = *i;
       g_operation = "write";
     }
+    else if (*i == "--phi-bins")
+    {
+      next_arg_or_die(mArgs, i);
+      g_phi_bins_file = *i;
+    }
+    else if (*i == "--tune-phi-bins")
+    {
+      next_arg_or_die(mArgs, i);
+      g_tune_phi_bins_file = *i;
+    }
     else if(*i == "--read-cmssw-tracks")
     {
       Config::readCmsswTracks = true;
@@ -866,6 +1306,19 @@ int main(int argc, const char *argv[])
     {
       Config::loopOverFile = true;
     }
+    else if (*i == "--mmap-input")
+    {
+      g_mmap_input = true;
+    }
+    else if (*i == "--read-ahead")
+    {
+      next_arg_or_die(mArgs, i);
+      g_read_ahead = atoi(i->c_str());
+    }
+    else if (*i == "--largest-first")
+    {
+      g_largest_first = true;
+    }
     else if (*i == "--num-tracks")
     {
       next_arg_or_die(mArgs, i);
@@ -886,11 +1339,28 @@ int main(int argc, const char *argv[])
       next_arg_or_die(mArgs, i);
       Config::numThreadsEvents = atoi(i->c_str());
     }
+    else if (*i == "--flow-graph")
+    {
+      g_flow_graph = true;
+    }
+    else if (*i == "--flow-graph-find")
+    {
+      next_arg_or_die(mArgs, i);
+      g_flow_graph_find = atoi(i->c_str());
+    }
     else if (*i == "--seeds-per-task")
     {
       next_arg_or_die(mArgs, i);
       Config::numSeedsPerTask = atoi(i->c_str());
     }
+    else if (*i == "--fill-lanes")
+    {
+      Config::finderFillLanes = true;
+    }
+    else if (*i == "--lane-stats")
+    {
+      Config::finderLaneStats = true;
+    }
     else if (*i == "--hits-per-task")
     {
       next_arg_or_die(mArgs, i);
@@ -982,6 +1452,10 @@ int main(int argc, const char *argv[])
     {
       Config::includePCA = true;
     }
+    else if (*i == "--iterative-helix-r")
+    {
+      Config::useIterativeHelixAtR = true;
+    }
     else if (*i == "--quality-val")
     {
       Config::quality_val = true; 
@@ -1129,6 +1603,11 @@ int main(int argc, const char *argv[])
     std::cerr << "What have you done?!? Short reco tracks are already accounted for in the MTV-Like Validation! Inclusive shorts is only an option for the standard simval, and will break the MTV-Like simval! Exiting..." << std::endl;
     exit(1);
   }
+  else if (g_flow_graph && (g_run_build_bh || g_run_build_cmssw))
+  {
+    std::cerr << "Flow graph runs Std, CE or FV building only, use --build-std, --build-ce or --build-fv. Exiting..." << std::endl;
+    exit(1);
+  }
 
   // set to convert if I/O files both set!
   if (g_input_file != "" && g_output_file != "")